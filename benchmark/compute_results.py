@@ -164,7 +164,7 @@ def compute_results(results_folder, output_base_name):
       read_times.append( avg_values[0] )
       write_times.append( avg_values[1] )
     all_read_times.append( read_times )
-    if (method != "miniply") and (method != "microply"):
+    if method != "microply":
       all_write_times.append( write_times )
 
   avg_read_table_filename = output_base_name + "_read_avg_table.md"
@@ -175,7 +175,6 @@ def compute_results(results_folder, output_base_name):
   print_full_table( model_names, method_names, all_read_times, full_read_table_filename )
   create_results_figure( model_names, method_names, all_read_times, read_fig_filename )
 
-  method_names.remove("miniply")
   method_names.remove("microply")
 
 
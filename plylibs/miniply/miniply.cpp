@@ -24,16 +24,47 @@ SOFTWARE.
 
 #include "miniply.h"
 
+#include <algorithm>
 #include <cassert>
 #include <cctype>
 #include <cmath>
 #include <cstdarg>
 #include <cstdio>
 #include <cstring>
+#include <condition_variable>
+#include <mutex>
 #include <string>
+#include <thread>
 
-#ifndef _WIN32
+#ifdef _WIN32
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
 #include <errno.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define MINIPLY_HAS_SSE2
+#include <emmintrin.h>
+#endif
+
+#if defined(__SSSE3__) || defined(__AVX__)
+#define MINIPLY_HAS_SSSE3
+#include <tmmintrin.h>
+#endif
+
+#if defined(__ARM_NEON) && defined(__aarch64__)
+#define MINIPLY_HAS_NEON
+#include <arm_neon.h>
 #endif
 
 
@@ -52,8 +83,34 @@ namespace miniply {
   // PLY constants
   //
 
-  static constexpr uint32_t kPLYReadBufferSize = 128 * 1024;
-  static constexpr uint32_t kPLYTempBufferSize = kPLYReadBufferSize;
+  static constexpr uint32_t kPLYMinReadBufferSize = 4 * 1024;
+  static constexpr uint32_t kPLYTempBufferSize = 128 * 1024;
+
+  // In `Prefetch` mode, this many bytes at the start of each read buffer are
+  // left free so that the unparsed end of the previous buffer can be put in
+  // front of the new data.
+  static constexpr uint32_t kPLYPrefetchHeadroom = 1024;
+
+  // ASCII element data is parsed in blocks of at most this many bytes, each of
+  // which is split between worker threads, with at least this many bytes and
+  // rows per thread.
+  static constexpr size_t kPLYAsciiBlockSize = 8 * 1024 * 1024;
+  static constexpr size_t kPLYMinAsciiBytesPerThread = 64 * 1024;
+  static constexpr uint32_t kPLYMinAsciiRowsPerThread = 2 * 1024;
+
+  // Faces are triangulated on multiple threads, with at least this many faces
+  // per thread.
+  static constexpr uint32_t kPLYMinFacesPerThread = 32 * 1024;
+
+  // Fixed-size rows are extracted in blocks of at most this many bytes.
+  static constexpr size_t kPLYExtractBlockSize = 16 * 1024;
+
+  // `probe_ply()` reads the file in pieces of this size until it has the
+  // whole header.
+  static constexpr size_t kPLYProbeReadSize = 4 * 1024;
+
+  static constexpr size_t kPLYWriteBufferSize = 1024 * 1024;
+  static constexpr size_t kPLYMaxAsciiValueLength = 32; // Enough for any value formatted by `format_ascii_value()`, plus a separator.
 
   static const char* kPLYFileTypes[] = { "ascii", "binary_little_endian", "binary_big_endian", nullptr };
   static const uint32_t kPLYPropertySize[]= { 1, 1, 2, 2, 4, 4, 4, 8 };
@@ -91,6 +148,16 @@ namespace miniply {
 
   static constexpr double kDoubleDigits[10] = { 0.0, 1.0, 2.0, 3.0, 4.0, 5.0, 6.0, 7.0, 8.0, 9.0 };
 
+  static constexpr double kPowersOf10[20] = {
+    1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9,
+    1e10, 1e11, 1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19,
+  };
+  static constexpr uint64_t kUIntPowersOf10[20] = {
+    1ull, 10ull, 100ull, 1000ull, 10000ull, 100000ull, 1000000ull, 10000000ull, 100000000ull, 1000000000ull,
+    10000000000ull, 100000000000ull, 1000000000000ull, 10000000000000ull, 100000000000000ull,
+    1000000000000000ull, 10000000000000000ull, 100000000000000000ull, 1000000000000000000ull, 10000000000000000000ull,
+  };
+
   static constexpr float kPi = 3.14159265358979323846f;
 
 
@@ -194,6 +261,89 @@ namespace miniply {
   }
 
 
+  // Maps the whole file into memory, read-only. The parser relies on there
+  // being a null char directly after the data, the same as for the read
+  // buffer, so this makes sure that the byte after the end of the file is
+  // readable and zero. Returns false if the file can't be mapped, e.g. because
+  // it's empty or isn't a regular file.
+  static bool file_map(const char* filename, char** data, size_t* size)
+  {
+  #ifdef _WIN32
+    HANDLE file = CreateFileA(filename, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+      return false;
+    }
+
+    // The rest of the last page of a view is zero filled, so we only have a
+    // null char after the data if the file doesn't end exactly on a page
+    // boundary.
+    SYSTEM_INFO sysInfo;
+    GetSystemInfo(&sysInfo);
+    LARGE_INTEGER fileSize;
+    if (!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart <= 0 || fileSize.QuadPart % sysInfo.dwPageSize == 0) {
+      CloseHandle(file);
+      return false;
+    }
+
+    HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    CloseHandle(file);
+    if (mapping == nullptr) {
+      return false;
+    }
+    void* view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    CloseHandle(mapping); // the view keeps the mapping alive.
+    if (view == nullptr) {
+      return false;
+    }
+
+    *data = static_cast<char*>(view);
+    *size = static_cast<size_t>(fileSize.QuadPart);
+    return true;
+  #else
+    int fd = open(filename, O_RDONLY);
+    if (fd < 0) {
+      return false;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode) || st.st_size <= 0) {
+      close(fd);
+      return false;
+    }
+    size_t fileSize = static_cast<size_t>(st.st_size);
+
+    // Reserve zeroed, anonymous memory for the file contents plus a null
+    // char, then map the file over the start of it.
+    void* base = mmap(nullptr, fileSize + 1, PROT_READ, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (base == MAP_FAILED) {
+      close(fd);
+      return false;
+    }
+    void* view = mmap(base, fileSize, PROT_READ, MAP_PRIVATE | MAP_FIXED, fd, 0);
+    close(fd);
+    if (view == MAP_FAILED) {
+      munmap(base, fileSize + 1);
+      return false;
+    }
+    madvise(view, fileSize, MADV_SEQUENTIAL);
+
+    *data = static_cast<char*>(view);
+    *size = fileSize;
+    return true;
+  #endif
+  }
+
+
+  static void file_unmap(char* data, size_t size)
+  {
+  #ifdef _WIN32
+    (void)size;
+    UnmapViewOfFile(data);
+  #else
+    munmap(data, size + 1);
+  #endif
+  }
+
+
   static bool int_literal(const char* start, char const** end, int* val)
   {
     const char* pos = start;
@@ -352,6 +502,240 @@ namespace miniply {
   }
 
 
+  static bool ascii_value(const char* start, char const** end, PLYPropertyType propType, uint8_t value[8])
+  {
+    int tmpInt = 0;
+
+    switch (propType) {
+    case PLYPropertyType::Char:
+    case PLYPropertyType::UChar:
+    case PLYPropertyType::Short:
+    case PLYPropertyType::UShort:
+      if (!int_literal(start, end, &tmpInt)) {
+        return false;
+      }
+      break;
+    case PLYPropertyType::Int:
+    case PLYPropertyType::UInt:
+      return int_literal(start, end, reinterpret_cast<int*>(value));
+    case PLYPropertyType::Float:
+      return float_literal(start, end, reinterpret_cast<float*>(value));
+    case PLYPropertyType::Double:
+    default:
+      return double_literal(start, end, reinterpret_cast<double*>(value));
+    }
+
+    switch (propType) {
+    case PLYPropertyType::Char:
+      reinterpret_cast<int8_t*>(value)[0] = static_cast<int8_t>(tmpInt);
+      break;
+    case PLYPropertyType::UChar:
+      value[0] = static_cast<uint8_t>(tmpInt);
+      break;
+    case PLYPropertyType::Short:
+      reinterpret_cast<int16_t*>(value)[0] = static_cast<int16_t>(tmpInt);
+      break;
+    case PLYPropertyType::UShort:
+      reinterpret_cast<uint16_t*>(value)[0] = static_cast<uint16_t>(tmpInt);
+      break;
+    default:
+      break;
+    }
+    return true;
+  }
+
+
+  static inline bool starts_with(const char* pos, const char* end, const char* str)
+  {
+    while (pos < end && *str != '\0' && *pos == *str) {
+      ++pos;
+      ++str;
+    }
+    return *str == '\0';
+  }
+
+
+  // Comment lines can appear between the rows of an ASCII element. These are
+  // skipped, the same as `PLYReader::next_line()` does.
+  static inline bool is_comment_line(const char* pos, const char* end)
+  {
+    return starts_with(pos, end, "comment") || starts_with(pos, end, "obj_info");
+  }
+
+
+  static inline const char* skip_line(const char* pos, const char* end)
+  {
+    const char* newline = static_cast<const char*>(std::memchr(pos, '\n', static_cast<size_t>(end - pos)));
+    return (newline != nullptr) ? newline + 1 : end;
+  }
+
+
+  // Counts the ASCII element rows in the lines from `pos` to `end`, where
+  // `pos` is the start of a line.
+  static uint32_t count_ascii_rows(const char* pos, const char* end)
+  {
+    uint32_t numRows = 0;
+    while (pos < end) {
+      if (!is_comment_line(pos, end)) {
+        ++numRows;
+      }
+      pos = skip_line(pos, end);
+    }
+    return numRows;
+  }
+
+
+  // Returns the end of the line holding the `maxRows`th row from `pos`, not
+  // counting comment lines, or `end` if there are fewer rows than that.
+  static const char* ascii_rows_end(const char* pos, const char* end, uint32_t maxRows)
+  {
+    uint32_t numRows = 0;
+    while (pos < end && numRows < maxRows) {
+      if (!is_comment_line(pos, end)) {
+        ++numRows;
+      }
+      pos = skip_line(pos, end);
+    }
+    return pos;
+  }
+
+
+  // Returns the end of the last complete line that fits in the first
+  // `maxBytes` bytes from `pos`, or `pos` if there isn't one.
+  static const char* ascii_block_end(const char* pos, const char* end, size_t maxBytes)
+  {
+    const char* blockEnd = (static_cast<size_t>(end - pos) > maxBytes) ? pos + maxBytes : end;
+    while (blockEnd > pos && blockEnd[-1] != '\n') {
+      --blockEnd;
+    }
+    return blockEnd;
+  }
+
+
+  static uint32_t num_worker_threads()
+  {
+    uint32_t numThreads = std::thread::hardware_concurrency();
+    return (numThreads > 0) ? numThreads : 1;
+  }
+
+
+  // Calls `fn(i)` for every `i` in [0, n), each on its own thread. The last
+  // call happens on the calling thread.
+  template <class Fn>
+  static void parallel_for(uint32_t n, Fn fn)
+  {
+    std::vector<std::thread> threads;
+    threads.reserve(n);
+    for (uint32_t i = 0; i + 1 < n; i++) {
+      threads.emplace_back(fn, i);
+    }
+    if (n > 0) {
+      fn(n - 1);
+    }
+    for (std::thread& thread : threads) {
+      thread.join();
+    }
+  }
+
+
+  static char* format_uint(char* pos, uint64_t value)
+  {
+    char tmp[20];
+    char* digits = tmp + sizeof(tmp);
+    do {
+      *--digits = static_cast<char>('0' + value % 10);
+      value /= 10;
+    } while (value != 0);
+    size_t numDigits = static_cast<size_t>(tmp + sizeof(tmp) - digits);
+    std::memcpy(pos, digits, numDigits);
+    return pos + numDigits;
+  }
+
+
+  static char* format_int(char* pos, int64_t value)
+  {
+    if (value < 0) {
+      *pos++ = '-';
+      return format_uint(pos, uint64_t(0) - static_cast<uint64_t>(value));
+    }
+    return format_uint(pos, static_cast<uint64_t>(value));
+  }
+
+
+  // Writes the shortest decimal representation of `value`, with up to 9
+  // significant digits for a float or 15 for a double, that reads back as
+  // the same value. Anything that isn't handled by this, like very small or
+  // large values, goes through snprintf instead.
+  static char* format_real(char* pos, double value, bool isFloat)
+  {
+    const double absValue = std::fabs(value);
+    if (absValue == 0.0) {
+      *pos++ = '0';
+      return pos;
+    }
+
+    if (absValue >= 1e-5 && absValue < 1e15) {
+      const int exp10 = static_cast<int>(std::floor(std::log10(absValue)));
+      const int maxDigits = isFloat ? 9 : 15;
+      for (int digits = isFloat ? 6 : 15; digits <= maxDigits; digits++) {
+        int fracDigits = digits - 1 - exp10;
+        if (fracDigits < 0) {
+          fracDigits = 0;
+        }
+        double scaled = absValue * kPowersOf10[fracDigits] + 0.5;
+        if (fracDigits >= 20 || scaled >= 9007199254740992.0) { // 2^53
+          break;
+        }
+        uint64_t mantissa = static_cast<uint64_t>(scaled);
+        double roundTrip = static_cast<double>(mantissa) / kPowersOf10[fracDigits];
+        bool exact = isFloat ? (static_cast<float>(roundTrip) == static_cast<float>(absValue)) : (roundTrip == absValue);
+        if (!exact && (digits < maxDigits || !isFloat)) {
+          continue;
+        }
+
+        if (value < 0.0) {
+          *pos++ = '-';
+        }
+        pos = format_uint(pos, mantissa / kUIntPowersOf10[fracDigits]);
+        uint64_t frac = mantissa % kUIntPowersOf10[fracDigits];
+        if (frac != 0) {
+          *pos++ = '.';
+          while (frac % 10 == 0) {
+            frac /= 10;
+            --fracDigits;
+          }
+          for (char* digit = pos + fracDigits - 1; digit >= pos; digit--) {
+            *digit = static_cast<char>('0' + frac % 10);
+            frac /= 10;
+          }
+          pos += fracDigits;
+        }
+        return pos;
+      }
+    }
+
+    int len = snprintf(pos, kPLYMaxAsciiValueLength, "%.*g", isFloat ? 9 : 17, value);
+    return pos + ((len > 0) ? len : 0);
+  }
+
+
+  static char* format_ascii_value(char* pos, PLYPropertyType type, const uint8_t value[8])
+  {
+    switch (type) {
+    case PLYPropertyType::Char:   return format_int(pos, *reinterpret_cast<const int8_t*>(value));
+    case PLYPropertyType::UChar:  return format_uint(pos, *reinterpret_cast<const uint8_t*>(value));
+    case PLYPropertyType::Short:  return format_int(pos, *reinterpret_cast<const int16_t*>(value));
+    case PLYPropertyType::UShort: return format_uint(pos, *reinterpret_cast<const uint16_t*>(value));
+    case PLYPropertyType::Int:    return format_int(pos, *reinterpret_cast<const int32_t*>(value));
+    case PLYPropertyType::UInt:   return format_uint(pos, *reinterpret_cast<const uint32_t*>(value));
+    case PLYPropertyType::Float:  return format_real(pos, *reinterpret_cast<const float*>(value), true);
+    case PLYPropertyType::Double: return format_real(pos, *reinterpret_cast<const double*>(value), false);
+    case PLYPropertyType::None:   break;
+    }
+    return pos;
+  }
+
+
   static inline void endian_swap_2(uint8_t* data)
   {
     uint16_t tmp = *reinterpret_cast<uint16_t*>(data);
@@ -390,21 +774,74 @@ namespace miniply {
   }
 
 
-  static inline void endian_swap_array(uint8_t* data, PLYPropertyType type, int n)
+#if defined(MINIPLY_HAS_SSSE3)
+  static inline void shuffle_16(uint8_t* data, const uint8_t mask[16])
   {
-    switch (kPLYPropertySize[uint32_t(type)]) {
+    __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data));
+    v = _mm_shuffle_epi8(v, _mm_loadu_si128(reinterpret_cast<const __m128i*>(mask)));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(data), v);
+  }
+#elif defined(MINIPLY_HAS_NEON)
+  static inline void shuffle_16(uint8_t* data, const uint8_t mask[16])
+  {
+    vst1q_u8(data, vqtbl1q_u8(vld1q_u8(data), vld1q_u8(mask)));
+  }
+#endif
+
+
+  // Swaps the endianness of `n` consecutive values of the given type, 16
+  // bytes at a time where SSE2 or NEON is available.
+  static void endian_swap_array(uint8_t* data, PLYPropertyType type, size_t n)
+  {
+    const uint32_t numBytes = kPLYPropertySize[uint32_t(type)];
+    if (numBytes == 1) {
+      return;
+    }
+
+    uint8_t* end = data + n * numBytes;
+#if defined(MINIPLY_HAS_SSSE3)
+    static const uint8_t kSwapMasks[3][16] = {
+      { 1, 0, 3, 2, 5, 4, 7, 6, 9, 8, 11, 10, 13, 12, 15, 14 },
+      { 3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12 },
+      { 7, 6, 5, 4, 3, 2, 1, 0, 15, 14, 13, 12, 11, 10, 9, 8 },
+    };
+    const uint8_t* mask = kSwapMasks[numBytes == 2 ? 0 : (numBytes == 4 ? 1 : 2)];
+    for (; data + 16 <= end; data += 16) {
+      shuffle_16(data, mask);
+    }
+#elif defined(MINIPLY_HAS_SSE2)
+    for (; data + 16 <= end; data += 16) {
+      __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data));
+      v = _mm_or_si128(_mm_slli_epi16(v, 8), _mm_srli_epi16(v, 8));
+      if (numBytes > 2) {
+        v = _mm_shufflehi_epi16(_mm_shufflelo_epi16(v, _MM_SHUFFLE(2, 3, 0, 1)), _MM_SHUFFLE(2, 3, 0, 1));
+      }
+      if (numBytes > 4) {
+        v = _mm_shuffle_epi32(v, _MM_SHUFFLE(2, 3, 0, 1));
+      }
+      _mm_storeu_si128(reinterpret_cast<__m128i*>(data), v);
+    }
+#elif defined(MINIPLY_HAS_NEON)
+    for (; data + 16 <= end; data += 16) {
+      uint8x16_t v = vld1q_u8(data);
+      v = (numBytes == 2) ? vrev16q_u8(v) : ((numBytes == 4) ? vrev32q_u8(v) : vrev64q_u8(v));
+      vst1q_u8(data, v);
+    }
+#endif
+
+    switch (numBytes) {
     case 2:
-      for (const uint8_t* end = data + 2 * n; data < end; data += 2) {
+      for (; data < end; data += 2) {
         endian_swap_2(data);
       }
       break;
     case 4:
-      for (const uint8_t* end = data + 4 * n; data < end; data += 4) {
+      for (; data < end; data += 4) {
         endian_swap_4(data);
       }
       break;
     case 8:
-      for (const uint8_t* end = data + 8 * n; data < end; data += 8) {
+      for (; data < end; data += 8) {
         endian_swap_8(data);
       }
       break;
@@ -414,6 +851,135 @@ namespace miniply {
   }
 
 
+  // Swaps the endianness of every value in `numRows` rows of fixed-size row
+  // data for the given element. List properties aren't part of the rows. If
+  // all values in a row have the same size, the rows are swapped as a single
+  // array. Otherwise, with SSSE3 or NEON, the rows are swapped with 16 byte
+  // shuffles whose masks are worked out up front.
+  static void endian_swap_rows(uint8_t* data, const PLYElement& elem, size_t numRows)
+  {
+    PLYPropertyType valueType = PLYPropertyType::None;
+    uint32_t numValues = 0;
+    bool sameSize = true;
+    for (const PLYProperty& prop : elem.properties) {
+      if (prop.countType != PLYPropertyType::None) {
+        continue;
+      }
+      if (valueType == PLYPropertyType::None) {
+        valueType = prop.type;
+      }
+      else if (kPLYPropertySize[uint32_t(prop.type)] != kPLYPropertySize[uint32_t(valueType)]) {
+        sameSize = false;
+      }
+      numValues++;
+    }
+    if (valueType == PLYPropertyType::None) {
+      return;
+    }
+    if (sameSize) {
+      endian_swap_array(data, valueType, numRows * numValues);
+      return;
+    }
+
+    size_t row = 0;
+#if defined(MINIPLY_HAS_SSSE3) || defined(MINIPLY_HAS_NEON)
+    // The layout of values within 16 byte windows repeats every
+    // lcm(16, rowStride) bytes, so we work out one shuffle mask per window in
+    // that period and apply them to consecutive, non-overlapping windows.
+    // Values which straddle two windows are left alone by the shuffles and
+    // swapped afterwards in a separate pass.
+    static const uint32_t kMaxSwapWindows = 256;
+    uint32_t gcd = elem.rowStride;
+    for (uint32_t b = 16; b != 0; ) {
+      uint32_t t = gcd % b;
+      gcd = b;
+      b = t;
+    }
+    const uint32_t rowsPerPeriod = 16 / gcd;
+    const uint32_t numWindows = elem.rowStride / gcd;
+    const size_t periodBytes = size_t(numWindows) * 16;
+    const size_t numPeriods = numRows / rowsPerPeriod;
+    if (numWindows <= kMaxSwapWindows && numPeriods > 0) {
+      uint8_t masks[kMaxSwapWindows * 16];
+      for (uint32_t i = 0; i < numWindows * 16; i++) {
+        masks[i] = static_cast<uint8_t>(i % 16);
+      }
+      std::vector<uint32_t> straddlers; // offset << 4 | size
+      for (uint32_t r = 0; r < rowsPerPeriod; r++) {
+        for (const PLYProperty& prop : elem.properties) {
+          const uint32_t numBytes = kPLYPropertySize[uint32_t(prop.type)];
+          if (prop.countType != PLYPropertyType::None || numBytes == 1) {
+            continue;
+          }
+          const uint32_t start = r * elem.rowStride + prop.offset;
+          if ((start / 16) != ((start + numBytes - 1) / 16)) {
+            straddlers.push_back((start << 4) | numBytes);
+            continue;
+          }
+          for (uint32_t i = 0; i < numBytes; i++) {
+            masks[start + i] = static_cast<uint8_t>(((start + numBytes - 1 - i) % 16));
+          }
+        }
+      }
+
+      // The straddlers are swapped a few KB behind the shuffles, so that the
+      // data is still in cache but the shuffles' stores have retired.
+      const size_t periodsPerChunk = std::max<size_t>(1, 4096 / periodBytes);
+      for (size_t p = 0; p < numPeriods; p += periodsPerChunk) {
+        uint8_t* chunk = data + p * periodBytes;
+        uint8_t* chunkEnd = data + std::min(p + periodsPerChunk, numPeriods) * periodBytes;
+        for (uint8_t* period = chunk; period < chunkEnd; period += periodBytes) {
+          for (uint32_t w = 0; w < numWindows; w++) {
+            shuffle_16(period + w * 16, masks + w * 16);
+          }
+        }
+        for (uint8_t* period = chunk; period < chunkEnd; period += periodBytes) {
+          for (uint32_t straddler : straddlers) {
+            uint8_t* value = period + (straddler >> 4);
+            switch (straddler & 0xF) {
+            case 2:
+              endian_swap_2(value);
+              break;
+            case 4:
+              endian_swap_4(value);
+              break;
+            default:
+              endian_swap_8(value);
+              break;
+            }
+          }
+        }
+      }
+      row = numPeriods * rowsPerPeriod;
+    }
+#endif
+
+    data += row * elem.rowStride;
+    for (; row < numRows; row++) {
+      for (const PLYProperty& prop : elem.properties) {
+        if (prop.countType != PLYPropertyType::None) {
+          continue;
+        }
+        size_t numBytes = kPLYPropertySize[uint32_t(prop.type)];
+        switch (numBytes) {
+        case 2:
+          endian_swap_2(data);
+          break;
+        case 4:
+          endian_swap_4(data);
+          break;
+        case 8:
+          endian_swap_8(data);
+          break;
+        default:
+          break;
+        }
+        data += numBytes;
+      }
+    }
+  }
+
+
   template <class T>
   static void copy_and_convert_to(T* dest, const uint8_t* src, PLYPropertyType srcType)
   {
@@ -447,6 +1013,25 @@ namespace miniply {
   }
 
 
+  // Decodes a list count from a binary file. Counts are the only values in a
+  // big-endian file which get swapped one at a time, as we need them to find
+  // where the list data ends.
+  static inline int binary_list_count(const char* pos, PLYPropertyType countType, bool bigEndian)
+  {
+    int count = 0;
+    if (bigEndian) {
+      uint8_t tmp[8];
+      std::memcpy(tmp, pos, kPLYPropertySize[uint32_t(countType)]);
+      endian_swap(tmp, countType);
+      copy_and_convert_to(&count, tmp, countType);
+    }
+    else {
+      copy_and_convert_to(&count, reinterpret_cast<const uint8_t*>(pos), countType);
+    }
+    return count;
+  }
+
+
   static inline bool compatible_types(PLYPropertyType srcType, PLYPropertyType destType)
   {
     return (srcType == destType) ||
@@ -455,20 +1040,480 @@ namespace miniply {
 
 
   //
-  // PLYElement methods
+  // Column copy & conversion kernels
   //
 
-  void PLYElement::calculate_offsets()
+  // Copies or converts `numRows` values from a strided source column into a
+  // strided destination column. The kernel for a pair of types is looked up
+  // once with `column_kernel()`, so the loops have no per-value type switch.
+  typedef void (*ColumnKernel)(uint8_t* dest, size_t destStride, const uint8_t* src, size_t srcStride, size_t numRows);
+
+
+  template <size_t N>
+  static void copy_column(uint8_t* dest, size_t destStride, const uint8_t* src, size_t srcStride, size_t numRows)
   {
-    fixedSize = true;
-    for (PLYProperty& prop : properties) {
-      if (prop.countType != PLYPropertyType::None) {
-        fixedSize = false;
-        break;
-      }
+    for (size_t row = 0; row < numRows; row++, dest += destStride, src += srcStride) {
+      std::memcpy(dest, src, N);
     }
+  }
 
-    // Note that each list property gets its own separate storage. Only fixed
+
+  template <class D, class S>
+  static void convert_values(uint8_t* dest, size_t destStride, const uint8_t* src, size_t srcStride, size_t numRows)
+  {
+    for (size_t row = 0; row < numRows; row++, dest += destStride, src += srcStride) {
+      S value;
+      std::memcpy(&value, src, sizeof(S));
+      const D converted = static_cast<D>(value);
+      std::memcpy(dest, &converted, sizeof(D));
+    }
+  }
+
+
+  template <class D>
+  static ColumnKernel convert_values_kernel(PLYPropertyType srcType)
+  {
+    switch (srcType) {
+    case PLYPropertyType::Char:   return convert_values<D, int8_t>;
+    case PLYPropertyType::UChar:  return convert_values<D, uint8_t>;
+    case PLYPropertyType::Short:  return convert_values<D, int16_t>;
+    case PLYPropertyType::UShort: return convert_values<D, uint16_t>;
+    case PLYPropertyType::Int:    return convert_values<D, int32_t>;
+    case PLYPropertyType::UInt:   return convert_values<D, uint32_t>;
+    case PLYPropertyType::Float:  return convert_values<D, float>;
+    case PLYPropertyType::Double: return convert_values<D, double>;
+    case PLYPropertyType::None:   break;
+    }
+    return nullptr;
+  }
+
+
+  // Returns nullptr if either type is `PLYPropertyType::None`.
+  static ColumnKernel column_kernel(PLYPropertyType destType, PLYPropertyType srcType)
+  {
+    if (srcType == PLYPropertyType::None || destType == PLYPropertyType::None) {
+      return nullptr;
+    }
+    if (compatible_types(srcType, destType)) {
+      switch (kPLYPropertySize[uint32_t(destType)]) {
+      case 1: return copy_column<1>;
+      case 2: return copy_column<2>;
+      case 4: return copy_column<4>;
+      case 8: return copy_column<8>;
+      default: break;
+      }
+    }
+    switch (destType) {
+    case PLYPropertyType::Char:   return convert_values_kernel<int8_t>(srcType);
+    case PLYPropertyType::UChar:  return convert_values_kernel<uint8_t>(srcType);
+    case PLYPropertyType::Short:  return convert_values_kernel<int16_t>(srcType);
+    case PLYPropertyType::UShort: return convert_values_kernel<uint16_t>(srcType);
+    case PLYPropertyType::Int:    return convert_values_kernel<int32_t>(srcType);
+    case PLYPropertyType::UInt:   return convert_values_kernel<uint32_t>(srcType);
+    case PLYPropertyType::Float:  return convert_values_kernel<float>(srcType);
+    case PLYPropertyType::Double: return convert_values_kernel<double>(srcType);
+    case PLYPropertyType::None:   break;
+    }
+    return nullptr;
+  }
+
+
+  // Copies `numRows` values from a strided source column into a strided
+  // destination column, converting them from `srcType` to `destType`. This is
+  // used for writing blocks of fixed-size rows.
+  static void convert_column(uint8_t* dest, size_t destStride, PLYPropertyType destType,
+                             const uint8_t* src, size_t srcStride, PLYPropertyType srcType, size_t numRows)
+  {
+    ColumnKernel kernel = column_kernel(destType, srcType);
+    if (kernel != nullptr) {
+      kernel(dest, destStride, src, srcStride, numRows);
+    }
+  }
+
+
+#ifdef MINIPLY_HAS_SSE2
+  static inline void store_as_floats(uint8_t* dest, __m128i values)
+  {
+    _mm_storeu_ps(reinterpret_cast<float*>(dest), _mm_cvtepi32_ps(values));
+  }
+#endif
+
+
+  // Converts `n` packed values from `srcType` to `destType`. Conversions to
+  // float from 8, 16 and 32 bit ints and from double, and from float to
+  // double, have SSE2 versions. The results are the same as for the scalar
+  // kernels, which handle everything else and any leftover values.
+  static void convert_array(uint8_t* dest, PLYPropertyType destType, const uint8_t* src, PLYPropertyType srcType, size_t n)
+  {
+    ColumnKernel kernel = column_kernel(destType, srcType);
+    if (kernel == nullptr) {
+      return;
+    }
+
+    size_t i = 0;
+#ifdef MINIPLY_HAS_SSE2
+    const __m128i zero = _mm_setzero_si128();
+    if (destType == PLYPropertyType::Float) {
+      switch (srcType) {
+      case PLYPropertyType::Char:
+        for (; i + 16 <= n; i += 16) {
+          __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+          __m128i lo = _mm_srai_epi16(_mm_unpacklo_epi8(v, v), 8);
+          __m128i hi = _mm_srai_epi16(_mm_unpackhi_epi8(v, v), 8);
+          store_as_floats(dest + i * 4,      _mm_srai_epi32(_mm_unpacklo_epi16(lo, lo), 16));
+          store_as_floats(dest + i * 4 + 16, _mm_srai_epi32(_mm_unpackhi_epi16(lo, lo), 16));
+          store_as_floats(dest + i * 4 + 32, _mm_srai_epi32(_mm_unpacklo_epi16(hi, hi), 16));
+          store_as_floats(dest + i * 4 + 48, _mm_srai_epi32(_mm_unpackhi_epi16(hi, hi), 16));
+        }
+        break;
+      case PLYPropertyType::UChar:
+        for (; i + 16 <= n; i += 16) {
+          __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+          __m128i lo = _mm_unpacklo_epi8(v, zero);
+          __m128i hi = _mm_unpackhi_epi8(v, zero);
+          store_as_floats(dest + i * 4,      _mm_unpacklo_epi16(lo, zero));
+          store_as_floats(dest + i * 4 + 16, _mm_unpackhi_epi16(lo, zero));
+          store_as_floats(dest + i * 4 + 32, _mm_unpacklo_epi16(hi, zero));
+          store_as_floats(dest + i * 4 + 48, _mm_unpackhi_epi16(hi, zero));
+        }
+        break;
+      case PLYPropertyType::Short:
+        for (; i + 8 <= n; i += 8) {
+          __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i * 2));
+          store_as_floats(dest + i * 4,      _mm_srai_epi32(_mm_unpacklo_epi16(v, v), 16));
+          store_as_floats(dest + i * 4 + 16, _mm_srai_epi32(_mm_unpackhi_epi16(v, v), 16));
+        }
+        break;
+      case PLYPropertyType::UShort:
+        for (; i + 8 <= n; i += 8) {
+          __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i * 2));
+          store_as_floats(dest + i * 4,      _mm_unpacklo_epi16(v, zero));
+          store_as_floats(dest + i * 4 + 16, _mm_unpackhi_epi16(v, zero));
+        }
+        break;
+      case PLYPropertyType::Int:
+        for (; i + 4 <= n; i += 4) {
+          store_as_floats(dest + i * 4, _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i * 4)));
+        }
+        break;
+      case PLYPropertyType::Double:
+        for (; i + 4 <= n; i += 4) {
+          __m128 lo = _mm_cvtpd_ps(_mm_loadu_pd(reinterpret_cast<const double*>(src + i * 8)));
+          __m128 hi = _mm_cvtpd_ps(_mm_loadu_pd(reinterpret_cast<const double*>(src + i * 8 + 16)));
+          _mm_storeu_ps(reinterpret_cast<float*>(dest + i * 4), _mm_movelh_ps(lo, hi));
+        }
+        break;
+      default:
+        break;
+      }
+    }
+    else if (destType == PLYPropertyType::Double && srcType == PLYPropertyType::Float) {
+      for (; i + 4 <= n; i += 4) {
+        __m128 v = _mm_loadu_ps(reinterpret_cast<const float*>(src + i * 4));
+        _mm_storeu_pd(reinterpret_cast<double*>(dest + i * 8),      _mm_cvtps_pd(v));
+        _mm_storeu_pd(reinterpret_cast<double*>(dest + i * 8 + 16), _mm_cvtps_pd(_mm_movehl_ps(v, v)));
+      }
+    }
+#endif
+    if (i < n) {
+      const size_t destSize = kPLYPropertySize[uint32_t(destType)];
+      const size_t srcSize = kPLYPropertySize[uint32_t(srcType)];
+      kernel(dest + i * destSize, destSize, src + i * srcSize, srcSize, n - i);
+    }
+  }
+
+
+  template <size_t N>
+  static void gather_rows(uint8_t* dest, const uint8_t* src, size_t srcStride, size_t numRows)
+  {
+    for (size_t row = 0; row < numRows; row++, dest += N, src += srcStride) {
+      std::memcpy(dest, src, N);
+    }
+  }
+
+
+  // Packs the `numBytes` bytes at the start of each of `numRows` rows into
+  // `dest`. The common run lengths get a fixed-size copy, e.g. 12 bytes for a
+  // float position amid other vertex properties.
+  static void gather_rows(uint8_t* dest, const uint8_t* src, size_t srcStride, size_t numBytes, size_t numRows)
+  {
+    switch (numBytes) {
+    case 2:  gather_rows<2> (dest, src, srcStride, numRows); return;
+    case 3:  gather_rows<3> (dest, src, srcStride, numRows); return;
+    case 4:  gather_rows<4> (dest, src, srcStride, numRows); return;
+    case 6:  gather_rows<6> (dest, src, srcStride, numRows); return;
+    case 8:  gather_rows<8> (dest, src, srcStride, numRows); return;
+    case 12: gather_rows<12>(dest, src, srcStride, numRows); return;
+    case 16: gather_rows<16>(dest, src, srcStride, numRows); return;
+    case 24: gather_rows<24>(dest, src, srcStride, numRows); return;
+    default: break;
+    }
+    for (size_t row = 0; row < numRows; row++, dest += numBytes, src += srcStride) {
+      std::memcpy(dest, src, numBytes);
+    }
+  }
+
+
+  // Copies the values of the given properties for `numRows` rows of
+  // fixed-size row data to `dest`, converting them to `destType` if necessary.
+  // This is shared by `PLYReader::extract_properties()` and loading elements
+  // straight into registered destinations.
+  static void extract_rows(const PLYElement& elem, const uint8_t* rows, size_t numRows,
+                           const uint32_t propIdxs[], uint32_t numProps, PLYPropertyType destType, uint8_t* dest)
+  {
+    if (destType == PLYPropertyType::None) {
+      return;
+    }
+
+    // Find out whether we have contiguous columns. If so, we may be able to
+    // use a more efficient data extraction technique.
+    bool contiguousCols = true;
+    uint32_t expectedOffset = elem.properties[propIdxs[0]].offset;
+    for (uint32_t i = 0; i < numProps; i++) {
+      uint32_t propIdx = propIdxs[i];
+      const PLYProperty& prop = elem.properties[propIdx];
+      if (prop.offset != expectedOffset) {
+        contiguousCols = false;
+        break;
+      }
+      expectedOffset = prop.offset + kPLYPropertySize[uint32_t(prop.type)];
+    }
+
+    // If the row we're extracting is contiguous in memory (i.e. there are no
+    // gaps anywhere in a row - start, end or middle), we can use an even MORE
+    // efficient data extraction technique.
+    bool contiguousRows = contiguousCols &&
+                          (elem.properties[propIdxs[0]].offset == 0) &&
+                          (expectedOffset == elem.rowStride);
+
+    // If no data conversion is required, we can memcpy chunks of data
+    // directly over to `dest`. How big those chunks will be depends on whether
+    // the columns and/or rows are contiguous, as determined above. If a
+    // conversion is required and all the columns have the same type, the
+    // values can be converted as one packed array.
+    const PLYPropertyType srcType = elem.properties[propIdxs[0]].type;
+    bool conversionRequired = false;
+    bool sameSrcType = true;
+    for (uint32_t i = 0; i < numProps; i++) {
+      uint32_t propIdx = propIdxs[i];
+      const PLYProperty& prop = elem.properties[propIdx];
+      if (!compatible_types(prop.type, destType)) {
+        conversionRequired = true;
+      }
+      if (prop.type != srcType) {
+        sameSrcType = false;
+      }
+    }
+
+    const size_t numBytesTotal = numRows * elem.rowStride;
+    const size_t colBytes = kPLYPropertySize[uint32_t(destType)]; // size of an output column in bytes.
+    const uint32_t firstOffset = elem.properties[propIdxs[0]].offset;
+    const size_t runBytes = expectedOffset - firstOffset;
+    if (!conversionRequired && contiguousRows) {
+      // Most efficient case is when the rows are contiguous. It means we're
+      // simply copying the entire data block for this element, which we can
+      // do with a single memcpy.
+      std::memcpy(dest, rows, numBytesTotal);
+    }
+    else if (!conversionRequired && contiguousCols) {
+      // If the rows aren't contiguous, but the columns we're extracting
+      // within each row are, then we can do a single copy per row.
+      gather_rows(dest, rows + firstOffset, elem.rowStride, runBytes, numRows);
+    }
+    else if (contiguousCols && sameSrcType && contiguousRows) {
+      // The whole block is a packed array of a single type.
+      convert_array(dest, destType, rows, srcType, numRows * numProps);
+    }
+    else if (contiguousCols && sameSrcType && runBytes <= kPLYExtractBlockSize) {
+      // Each row has a run of values with the same type, e.g. an RGB colour
+      // or a double precision position. Pack blocks of rows into a temporary
+      // buffer and convert each block as a single array.
+      uint8_t tmp[kPLYExtractBlockSize];
+      const size_t blockRows = kPLYExtractBlockSize / runBytes;
+      for (size_t row = 0; row < numRows; row += blockRows) {
+        const size_t n = std::min(blockRows, numRows - row);
+        gather_rows(tmp, rows + row * elem.rowStride + firstOffset, elem.rowStride, runBytes, n);
+        convert_array(dest + row * numProps * colBytes, destType, tmp, srcType, n * numProps);
+      }
+    }
+    else {
+      // Otherwise every column is processed separately, a block of rows at a
+      // time so that the block stays in the cache until all of its columns
+      // have been copied.
+      const size_t destStride = numProps * colBytes;
+      const size_t blockRows = std::max(size_t(1), kPLYExtractBlockSize / elem.rowStride);
+      for (size_t row = 0; row < numRows; row += blockRows) {
+        const size_t n = std::min(blockRows, numRows - row);
+        const uint8_t* from = rows + row * elem.rowStride;
+        uint8_t* to = dest + row * destStride;
+        for (uint32_t i = 0; i < numProps; i++) {
+          const PLYProperty& prop = elem.properties[propIdxs[i]];
+          ColumnKernel kernel = column_kernel(destType, prop.type);
+          if (kernel != nullptr) {
+            kernel(to + i * colBytes, destStride, from + prop.offset, elem.rowStride, n);
+          }
+        }
+      }
+    }
+  }
+
+
+  //
+  // Polygon triangulation internals
+  //
+
+  // Working storage for triangulating polygons. This is reused from one
+  // polygon to the next, so triangulating a run of faces only allocates when
+  // a face is bigger than any before it.
+  struct PolygonScratch {
+    std::vector<Vec2> points2D;
+    std::vector<uint32_t> prev;
+    std::vector<uint32_t> next;
+    std::vector<float> angles;
+    std::vector<int> indices; //!< Face indices converted to int, if the list type isn't int.
+    std::vector<int> tris;    //!< Triangle indices, before conversion to the destination type.
+  };
+
+
+  static float angle_at_vert(uint32_t idx,
+                             const std::vector<Vec2>& points2D,
+                             const std::vector<uint32_t>& prev,
+                             const std::vector<uint32_t>& next)
+  {
+    Vec2 xaxis = normalize(points2D[next[idx]] - points2D[idx]);
+    Vec2 yaxis = Vec2{-xaxis.y, xaxis.x};
+    Vec2 p2p0 = points2D[prev[idx]] - points2D[idx];
+    float angle = std::atan2(dot(p2p0, yaxis), dot(p2p0, xaxis));
+    if (angle <= 0.0f || angle >= kPi) {
+      angle = 10000.0f;
+    }
+    return angle;
+  }
+
+
+  // Same as the public `triangulate_polygon()`, but using `scratch` instead
+  // of allocating new working storage for each polygon.
+  static uint32_t triangulate_polygon(uint32_t n, const float pos[], uint32_t numVerts, const int indices[], int dst[], PolygonScratch& scratch)
+  {
+    if (n < 3) {
+      return 0;
+    }
+    else if (n == 3) {
+      dst[0] = indices[0];
+      dst[1] = indices[1];
+      dst[2] = indices[2];
+      return 1;
+    }
+    else if (n == 4) {
+      dst[0] = indices[0];
+      dst[1] = indices[1];
+      dst[2] = indices[3];
+
+      dst[3] = indices[2];
+      dst[4] = indices[3];
+      dst[5] = indices[1];
+      return 2;
+    }
+
+    // Check that all indices for this face are in the valid range before we
+    // try to dereference them.
+    for (uint32_t i = 0; i < n; i++) {
+      if (indices[i] < 0 || uint32_t(indices[i]) >= numVerts) {
+        return 0;
+      }
+    }
+
+    const uint32_t numTris = n - 2;
+    const Vec3* vpos = reinterpret_cast<const Vec3*>(pos);
+
+    // Calculate the geometric normal of the face
+    Vec3 origin = vpos[indices[0]];
+    Vec3 faceU = normalize(vpos[indices[1]] - origin);
+    Vec3 faceNormal = normalize(cross(faceU, normalize(vpos[indices[n - 1]] - origin)));
+    Vec3 faceV = normalize(cross(faceNormal, faceU));
+
+    // Project the faces points onto the plane perpendicular to the normal.
+    std::vector<Vec2>& points2D = scratch.points2D;
+    points2D.assign(n, Vec2{0.0f, 0.0f});
+    for (uint32_t i = 1; i < n; i++) {
+      Vec3 p = vpos[indices[i]] - origin;
+      points2D[i] = Vec2{dot(p, faceU), dot(p, faceV)};
+    }
+
+    std::vector<uint32_t>& next = scratch.next;
+    std::vector<uint32_t>& prev = scratch.prev;
+    next.resize(n);
+    prev.resize(n);
+    uint32_t first = 0;
+    for (uint32_t i = 0, j = n - 1; i < n; i++) {
+      next[j] = i;
+      prev[i] = j;
+      j = i;
+    }
+
+    // The angle at a vertex only depends on its neighbours, so after each
+    // clip only the angles at the two vertices either side of it change.
+    std::vector<float>& angles = scratch.angles;
+    angles.resize(n);
+    for (uint32_t i = 0; i < n; i++) {
+      angles[i] = angle_at_vert(i, points2D, prev, next);
+    }
+
+    // Do ear clipping.
+    while (n > 3) {
+      // Find the (remaining) vertex with the sharpest angle.
+      uint32_t bestI = first;
+      float bestAngle = angles[first];
+      for (uint32_t i = next[first]; i != first; i = next[i]) {
+        if (angles[i] < bestAngle) {
+          bestI = i;
+          bestAngle = angles[i];
+        }
+      }
+
+      // Clip the triangle at bestI.
+      uint32_t nextI = next[bestI];
+      uint32_t prevI = prev[bestI];
+
+      dst[0] = indices[bestI];
+      dst[1] = indices[nextI];
+      dst[2] = indices[prevI];
+      dst += 3;
+
+      if (bestI == first) {
+        first = nextI;
+      }
+      next[prevI] = nextI;
+      prev[nextI] = prevI;
+      angles[prevI] = angle_at_vert(prevI, points2D, prev, next);
+      angles[nextI] = angle_at_vert(nextI, points2D, prev, next);
+      --n;
+    }
+
+    // Add the final triangle.
+    dst[0] = indices[first];
+    dst[1] = indices[next[first]];
+    dst[2] = indices[prev[first]];
+
+    return numTris;
+  }
+
+
+  //
+  // PLYElement methods
+  //
+
+  void PLYElement::calculate_offsets()
+  {
+    fixedSize = true;
+    for (PLYProperty& prop : properties) {
+      if (prop.countType != PLYPropertyType::None) {
+        fixedSize = false;
+        break;
+      }
+    }
+
+    // Note that each list property gets its own separate storage. Only fixed
     // size properties go into the common data block. The `rowStride` is the
     // size of a row in the common data block.
     rowStride = 0;
@@ -576,33 +1621,265 @@ namespace miniply {
 
 
   //
-  // PLYReader methods
+  // PLYReader::Prefetcher type
   //
 
-  PLYReader::PLYReader(const char* filename)
-  {
-    m_buf = new char[kPLYReadBufferSize + 1];
-    m_buf[kPLYReadBufferSize] = '\0';
+  // Reads the file on a background thread, one buffer ahead of the parser.
+  // The parser and the thread each own a buffer of the same size. Whenever
+  // the parser has used up its buffer the two are swapped, and the thread
+  // starts filling the parser's old buffer with the next part of the file.
+  struct PLYReader::Prefetcher {
+    Prefetcher(FILE* f, size_t bufferSize);
+    ~Prefetcher();
+
+    // Exchanges `*buf` for the buffer that was filled in the background,
+    // copying the `keep` bytes at `tail` to just in front of the new data. On
+    // return `*buf` is the new buffer, `*pos` points at the kept bytes and
+    // `*offset` is the file offset of `(*buf)[0]`. Returns the number of bytes
+    // from the start of the new buffer to the end of the data, or 0 if `keep`
+    // bytes won't fit in front of the data, in which case nothing is changed.
+    size_t swap(char** buf, const char* tail, size_t keep, char** pos, int64_t* offset);
+
+    // Same as `fread`, except that it usually returns data which was already
+    // read in the background.
+    size_t read(char* dst, size_t numBytes);
+
+    // Sets the file offset for the next call to `read` or `swap`. This is free
+    // if the offset is within the part of the file that has already been read.
+    void seek(int64_t offset);
+
+  private:
+    void run();
+    void wait_for_data(std::unique_lock<std::mutex>& lock);
+
+    FILE* m_f;
+    char* m_data;                  // Background thread's buffer. Data starts at kPLYPrefetchHeadroom.
+    size_t m_capacity     = 0;     // Max number of bytes to read into m_data at a time.
+    size_t m_pos          = 0;     // Position of the next byte to hand out, relative to the start of the data.
+    size_t m_size         = 0;     // Number of valid bytes in m_data, after the headroom.
+    int64_t m_dataOffset  = 0;     // File offset of the first byte of data in m_data.
+    int64_t m_fileOffset  = 0;     // File offset that the next background read starts at.
+    bool m_atEOF          = false; // Whether the last background read reached the end of the file.
+    bool m_reading        = true;  // Whether the background thread owns m_data.
+    bool m_quit           = false;
+
+    std::mutex m_mutex;
+    std::condition_variable m_cond;
+    std::thread m_thread;
+  };
 
-    m_tmpBuf = new char[kPLYTempBufferSize + 1];
-    m_tmpBuf[kPLYTempBufferSize] = '\0';
 
-    m_bufEnd = m_buf + kPLYReadBufferSize;
-    m_pos = m_bufEnd;
-    m_end = m_bufEnd;
+  PLYReader::Prefetcher::Prefetcher(FILE* f, size_t bufferSize) :
+    m_f(f),
+    m_data(new char[bufferSize + 1]),
+    m_capacity(bufferSize - kPLYPrefetchHeadroom)
+  {
+    m_data[bufferSize] = '\0';
+    // The file has just been opened, so the first read starts at offset 0.
+    m_thread = std::thread(&Prefetcher::run, this);
+  }
 
-    if (file_open(&m_f, filename, "rb") != 0) {
-      m_f = nullptr;
-      m_valid = false;
-      return;
+
+  PLYReader::Prefetcher::~Prefetcher()
+  {
+    {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      m_quit = true;
     }
-    m_valid = true;
+    m_cond.notify_all();
+    m_thread.join();
+    delete[] m_data;
+  }
 
-    refill_buffer();
 
-    m_valid = keyword("ply") && next_line() &&
-              keyword("format") && advance() &&
-              typed_which(kPLYFileTypes, &m_fileType) && advance() &&
+  size_t PLYReader::Prefetcher::swap(char** buf, const char* tail, size_t keep, char** pos, int64_t* offset)
+  {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    wait_for_data(lock);
+
+    // If `read` or `seek` has already used up part of the data, the parser
+    // would get less than a full buffer's worth. Move the rest down and top it
+    // up from the file instead. This only happens once after a seek or after
+    // a tail too big for the headroom, then the reads line up again.
+    if (m_pos > keep && !m_atEOF) {
+      char* data = m_data + kPLYPrefetchHeadroom;
+      std::memmove(data, data + m_pos, m_size - m_pos);
+      m_size -= m_pos;
+      m_dataOffset += static_cast<int64_t>(m_pos);
+      m_pos = 0;
+      size_t fetched = fread(data + m_size, sizeof(char), m_capacity - m_size, m_f);
+      m_size += fetched;
+      m_fileOffset += static_cast<int64_t>(fetched);
+      m_atEOF = m_size < m_capacity;
+    }
+
+    size_t start = kPLYPrefetchHeadroom + m_pos;
+    if (keep > start) {
+      return 0;
+    }
+    std::memcpy(m_data + start - keep, tail, keep);
+    *pos = m_data + start - keep;
+    *offset = m_dataOffset - kPLYPrefetchHeadroom;
+    size_t fetched = kPLYPrefetchHeadroom + m_size;
+
+    char* next = m_data;
+    m_data = *buf;
+    *buf = next;
+
+    // Everything we had has been handed over, so start on the next part of
+    // the file straight away.
+    m_dataOffset = m_fileOffset;
+    m_pos = 0;
+    m_size = 0;
+    if (!m_atEOF) {
+      m_reading = true;
+      m_cond.notify_all();
+    }
+    return fetched;
+  }
+
+
+  size_t PLYReader::Prefetcher::read(char* dst, size_t numBytes)
+  {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    size_t fetched = 0;
+    while (fetched < numBytes) {
+      wait_for_data(lock);
+      if (m_pos == m_size) {
+        break; // EOF
+      }
+
+      size_t n = m_size - m_pos;
+      if (n > numBytes - fetched) {
+        n = numBytes - fetched;
+      }
+      std::memcpy(dst + fetched, m_data + kPLYPrefetchHeadroom + m_pos, n);
+      m_pos += n;
+      fetched += n;
+
+      // Start on the next part of the file as soon as we've used up this one.
+      if (m_pos == m_size && !m_atEOF) {
+        m_reading = true;
+        m_cond.notify_all();
+      }
+    }
+    return fetched;
+  }
+
+
+  void PLYReader::Prefetcher::seek(int64_t offset)
+  {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_cond.wait(lock, [this]() { return !m_reading; });
+    if (offset >= m_dataOffset && offset <= m_dataOffset + static_cast<int64_t>(m_size)) {
+      m_pos = static_cast<size_t>(offset - m_dataOffset);
+    }
+    else {
+      file_seek(m_f, offset, SEEK_SET);
+      m_fileOffset = offset;
+      m_dataOffset = offset;
+      m_pos = 0;
+      m_size = 0;
+      m_atEOF = false;
+    }
+    if (m_pos == m_size && !m_atEOF) {
+      m_reading = true;
+      m_cond.notify_all();
+    }
+  }
+
+
+  void PLYReader::Prefetcher::run()
+  {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    while (true) {
+      m_cond.wait(lock, [this]() { return m_reading || m_quit; });
+      if (m_quit) {
+        return;
+      }
+
+      char* dst = m_data + kPLYPrefetchHeadroom;
+      lock.unlock();
+      size_t fetched = fread(dst, sizeof(char), m_capacity, m_f);
+      lock.lock();
+
+      m_dataOffset = m_fileOffset;
+      m_fileOffset += static_cast<int64_t>(fetched);
+      m_pos = 0;
+      m_size = fetched;
+      m_atEOF = fetched < m_capacity;
+      m_reading = false;
+      m_cond.notify_all();
+    }
+  }
+
+
+  // Waits until the background thread has data which hasn't been handed out
+  // yet, or has reached the end of the file. Must be called with the lock held.
+  void PLYReader::Prefetcher::wait_for_data(std::unique_lock<std::mutex>& lock)
+  {
+    while (true) {
+      m_cond.wait(lock, [this]() { return !m_reading; });
+      if (m_pos < m_size || m_atEOF) {
+        return;
+      }
+      m_reading = true;
+      m_cond.notify_all();
+    }
+  }
+
+
+  //
+  // PLYReader methods
+  //
+
+  PLYReader::PLYReader(const char* filename, PLYReadMode mode, uint32_t bufferSize)
+  {
+    m_bufSize = (bufferSize > kPLYMinReadBufferSize) ? bufferSize : kPLYMinReadBufferSize;
+    if (mode == PLYReadMode::Prefetch) {
+      // Each background read is still `bufferSize` bytes, after the headroom.
+      m_bufSize += kPLYPrefetchHeadroom;
+    }
+
+    m_tmpBuf = new char[kPLYTempBufferSize + 1];
+    m_tmpBuf[kPLYTempBufferSize] = '\0';
+
+    size_t fileSize = 0;
+    if (mode == PLYReadMode::MemoryMapped && file_map(filename, &m_buf, &fileSize)) {
+      // The whole file is one big buffer, so there's never anything to refill.
+      m_readMode = PLYReadMode::MemoryMapped;
+      m_bufEnd = m_buf + fileSize;
+      m_pos = m_buf;
+      m_end = m_buf;
+      m_atEOF = true;
+      m_valid = true;
+    }
+    else {
+      m_buf = new char[m_bufSize + 1];
+      m_buf[m_bufSize] = '\0';
+
+      m_bufEnd = m_buf + m_bufSize;
+      m_pos = m_bufEnd;
+      m_end = m_bufEnd;
+
+      if (file_open(&m_f, filename, "rb") != 0) {
+        m_f = nullptr;
+        m_valid = false;
+        return;
+      }
+      m_valid = true;
+
+      if (mode == PLYReadMode::Prefetch) {
+        m_readMode = PLYReadMode::Prefetch;
+        m_prefetcher = new Prefetcher(m_f, m_bufSize);
+      }
+
+      refill_buffer();
+    }
+
+    m_valid = keyword("ply") && next_line() &&
+              keyword("format") && advance() &&
+              typed_which(kPLYFileTypes, &m_fileType) && advance() &&
               int_literal(&m_majorVersion) && advance() &&
               match(".") && advance() &&
               int_literal(&m_minorVersion) && next_line() &&
@@ -624,14 +1901,26 @@ namespace miniply {
 
   PLYReader::~PLYReader()
   {
+    delete m_prefetcher; // must finish with the file before we close it.
     if (m_f != nullptr) {
       fclose(m_f);
     }
-    delete[] m_buf;
+    if (m_readMode == PLYReadMode::MemoryMapped) {
+      file_unmap(m_buf, static_cast<size_t>(m_bufEnd - m_buf));
+    }
+    else {
+      delete[] m_buf;
+    }
     delete[] m_tmpBuf;
   }
 
 
+  PLYReadMode PLYReader::read_mode() const
+  {
+    return m_readMode;
+  }
+
+
   bool PLYReader::valid() const
   {
     return m_valid;
@@ -654,12 +1943,42 @@ namespace miniply {
   bool PLYReader::load_element()
   {
     assert(has_element());
+    PLYElement& elem = m_elements[m_currentElement];
     if (m_elementLoaded) {
-      return true;
+      // Only true if the whole element was loaded in one go.
+      return m_numLoadedRows == elem.count;
+    }
+    return load_rows(elem, elem.count);
+  }
+
+
+  bool PLYReader::load_element_rows(uint32_t maxRows)
+  {
+    if (!has_element() || !m_valid || maxRows == 0) {
+      return false;
     }
 
     PLYElement& elem = m_elements[m_currentElement];
-    return elem.fixedSize ? load_fixed_size_element(elem) : load_variable_size_element(elem);
+    if (m_nextRow == elem.count) {
+      return false;
+    }
+    uint32_t numRows = elem.count - m_nextRow;
+    if (numRows > maxRows) {
+      numRows = maxRows;
+    }
+    return load_rows(elem, numRows);
+  }
+
+
+  uint32_t PLYReader::first_loaded_row() const
+  {
+    return m_firstLoadedRow;
+  }
+
+
+  uint32_t PLYReader::num_loaded_rows() const
+  {
+    return m_numLoadedRows;
   }
 
 
@@ -669,10 +1988,12 @@ namespace miniply {
       return;
     }
 
-    // If the element was loaded, the read buffer should already be positioned at
-    // the start of the next element.
+    // The read buffer is positioned after the last row that was loaded, which
+    // is the start of the next element if the whole element was loaded.
     PLYElement& elem = m_elements[m_currentElement];
+    const uint32_t skipRows = elem.count - m_nextRow;
     m_currentElement++;
+    m_destinations.clear();
 
     if (m_elementLoaded) {
       // Clear any temporary storage used for list properties in the current element.
@@ -688,27 +2009,41 @@ namespace miniply {
 
       // Clear temporary storage for the non-list properties in the current element.
       m_elementData.clear();
+      m_elementRows = nullptr;
       m_elementLoaded = false;
+    }
+    m_nextRow = 0;
+    m_firstLoadedRow = 0;
+    m_numLoadedRows = 0;
+    if (skipRows == 0) {
       return;
     }
 
-    // If the element wasn't loaded, we have to move the file pointer past its
-    // contents. How we do that depends on whether this is an ASCII or binary
-    // file and, if it's a binary, whether the element is fixed or variable
-    // size.
+    // Move the file pointer past the rows that weren't loaded. How we do that
+    // depends on whether this is an ASCII or binary file and, if it's a
+    // binary, whether the element is fixed or variable size.
     if (m_fileType == PLYFileType::ASCII) {
-      for (uint32_t row = 0; row < elem.count; row++) {
+      for (uint32_t row = 0; row < skipRows; row++) {
         next_line();
       }
     }
+    else if (elem.fixedSize && m_readMode == PLYReadMode::MemoryMapped) {
+      size_t elementSize = size_t(elem.rowStride) * skipRows;
+      if (elementSize > static_cast<size_t>(m_bufEnd - m_pos)) {
+        m_valid = false;
+        return;
+      }
+      m_pos += elementSize;
+      m_end = m_pos;
+    }
     else if (elem.fixedSize) {
       int64_t elementStart = static_cast<int64_t>(m_pos - m_buf);
-      int64_t elementSize = elem.rowStride * elem.count;
+      int64_t elementSize = int64_t(elem.rowStride) * skipRows;
       int64_t elementEnd = elementStart + elementSize;
-      if (elementEnd >= kPLYReadBufferSize) {
+      if (elementEnd >= m_bufSize) {
         m_bufOffset += elementEnd;
-        file_seek(m_f, m_bufOffset, SEEK_SET);
-        m_bufEnd = m_buf + kPLYReadBufferSize;
+        seek_file(m_bufOffset);
+        m_bufEnd = m_buf + m_bufSize;
         m_pos = m_bufEnd;
         m_end = m_bufEnd;
         refill_buffer();
@@ -718,52 +2053,11 @@ namespace miniply {
         m_end = m_pos;
       }
     }
-    else if (m_fileType == PLYFileType::Binary) {
-      for (uint32_t row = 0; row < elem.count; row++) {
-        for (const PLYProperty& prop : elem.properties) {
-          if (prop.countType == PLYPropertyType::None) {
-            uint32_t numBytes = kPLYPropertySize[uint32_t(prop.type)];
-            if (m_pos + numBytes > m_bufEnd) {
-              if (!refill_buffer() || m_pos + numBytes > m_bufEnd) {
-                m_valid = false;
-                return;
-              }
-            }
-            m_pos += numBytes;
-            m_end = m_pos;
-            continue;
-          }
-
-          uint32_t numBytes = kPLYPropertySize[uint32_t(prop.countType)];
-          if (m_pos + numBytes > m_bufEnd) {
-            if (!refill_buffer() || m_pos + numBytes > m_bufEnd) {
-              m_valid = false;
-              return;
-            }
-          }
-
-          int count = 0;
-          copy_and_convert_to(&count, reinterpret_cast<const uint8_t*>(m_pos), prop.countType);
-
-          if (count < 0) {
-            m_valid = false;
-            return;
-          }
-
-          numBytes += uint32_t(count) * kPLYPropertySize[uint32_t(prop.type)];
-          if (m_pos + numBytes > m_bufEnd) {
-            if (!refill_buffer() || m_pos + numBytes > m_bufEnd) {
-              m_valid = false;
-              return;
-            }
-          }
-          m_pos += numBytes;
-          m_end = m_pos;
-        }
-      }
-    }
-    else { // PLYFileType::BinaryBigEndian
-      for (uint32_t row = 0; row < elem.count; row++) {
+    else {
+      // Only the list counts need decoding to skip over a variable-size
+      // element; none of the other values are swapped or converted.
+      const bool bigEndian = (m_fileType == PLYFileType::BinaryBigEndian);
+      for (uint32_t row = 0; row < skipRows; row++) {
         for (const PLYProperty& prop : elem.properties) {
           if (prop.countType == PLYPropertyType::None) {
             uint32_t numBytes = kPLYPropertySize[uint32_t(prop.type)];
@@ -786,12 +2080,7 @@ namespace miniply {
             }
           }
 
-          int count = 0;
-          uint8_t tmp[8];
-          memcpy(tmp, m_pos, numBytes);
-          endian_swap(tmp, prop.countType);
-          copy_and_convert_to(&count, tmp, prop.countType);
-
+          int count = binary_list_count(m_pos, prop.countType, bigEndian);
           if (count < 0) {
             m_valid = false;
             return;
@@ -804,7 +2093,6 @@ namespace miniply {
               return;
             }
           }
-
           m_pos += numBytes;
           m_end = m_pos;
         }
@@ -902,98 +2190,52 @@ namespace miniply {
       }
     }
 
-    // Find out whether we have contiguous columns. If so, we may be able to
-    // use a more efficient data extraction technique.
-    bool contiguousCols = true;
-    uint32_t expectedOffset = elem->properties[propIdxs[0]].offset;
-    for (uint32_t i = 0; i < numProps; i++) {
-      uint32_t propIdx = propIdxs[i];
-      const PLYProperty& prop = elem->properties[propIdx];
-      if (prop.offset != expectedOffset) {
-        contiguousCols = false;
-        break;
-      }
-      expectedOffset = prop.offset + kPLYPropertySize[uint32_t(prop.type)];
-    }
+    // Nothing to extract if the element hasn't been loaded.
+    size_t numRows = (m_elementRows != nullptr) ? m_numLoadedRows : 0;
+    extract_rows(*elem, m_elementRows, numRows, propIdxs, numProps, destType, reinterpret_cast<uint8_t*>(dest));
+    return true;
+  }
 
-    // If the row we're extracting is contiguous in memory (i.e. there are no
-    // gaps anywhere in a row - start, end or middle), we can use an even MORE
-    // efficient data extraction technique.
-    bool contiguousRows = contiguousCols &&
-                          (elem->properties[propIdxs[0]].offset == 0) &&
-                          (expectedOffset == elem->rowStride);
 
-    // If no data conversion is required, we can memcpy chunks of data
-    // directly over to `dest`. How big those chunks will be depends on whether
-    // the columns and/or rows are contiguous, as determined above.
-    bool conversionRequired = false;
+  bool PLYReader::set_destination(const uint32_t propIdxs[], uint32_t numProps, PLYPropertyType destType, void* dest)
+  {
+    if (!has_element() || m_elementLoaded || numProps == 0 || destType == PLYPropertyType::None || dest == nullptr) {
+      return false;
+    }
+
+    const PLYElement* elem = element();
     for (uint32_t i = 0; i < numProps; i++) {
-      uint32_t propIdx = propIdxs[i];
-      const PLYProperty& prop = elem->properties[propIdx];
-      if (!compatible_types(prop.type, destType)) {
-        conversionRequired = true;
-        break;
+      if (propIdxs[i] >= elem->properties.size() || elem->properties[propIdxs[i]].countType != PLYPropertyType::None) {
+        return false;
       }
     }
 
-    uint8_t* to = reinterpret_cast<uint8_t*>(dest);
-    if (!conversionRequired) {
-      // If no data conversion is required, we can just use memcpy to get
-      // values into dest.
-      if (contiguousRows) {
-        // Most efficient case is when the rows are contiguous. It means we're
-        // simply copying the entire data block for this element, which we can
-        // do with a single memcpy.
-        std::memcpy(to, m_elementData.data(), m_elementData.size());
-      }
-      else if (contiguousCols) {
-        // If the rows aren't contiguous, but the columns we're extracting
-        // within each row are, then we can do a single memcpy per row.
-        const uint8_t* from = m_elementData.data() + elem->properties[propIdxs[0]].offset;
-        const uint8_t* end = m_elementData.data() + m_elementData.size();
-        const size_t numBytes = expectedOffset - elem->properties[propIdxs[0]].offset;
-        while (from < end) {
-          std::memcpy(to, from, numBytes);
-          from += elem->rowStride;
-          to += numBytes;
-        }
-      }
-      else {
-        // If the columns aren't contiguous, we must memcpy each one separately.
-        const uint8_t* row = m_elementData.data();
-        const uint8_t* end = m_elementData.data() + m_elementData.size();
-        uint8_t* to = reinterpret_cast<uint8_t*>(dest);
-        size_t colBytes = kPLYPropertySize[uint32_t(destType)]; // size of an output column in bytes.
-        while (row < end) {
-          for (uint32_t i = 0; i < numProps; i++) {
-            uint32_t propIdx = propIdxs[i];
-            const PLYProperty& prop = elem->properties[propIdx];
-            std::memcpy(to, row + prop.offset, colBytes);
-            to += colBytes;
-          }
-          row += elem->rowStride;
-        }
-      }
+    m_destinations.push_back(Destination());
+    Destination& destination = m_destinations.back();
+    destination.propIdxs.assign(propIdxs, propIdxs + numProps);
+    destination.type = destType;
+    destination.data = reinterpret_cast<uint8_t*>(dest);
+    return true;
+  }
+
+
+  bool PLYReader::set_list_destination(uint32_t propIdx, uint32_t listSize, PLYPropertyType destType, void* dest)
+  {
+    if (!has_element() || m_elementLoaded || listSize == 0 || destType == PLYPropertyType::None || dest == nullptr) {
+      return false;
     }
-    else {
-      // We will have to do data type conversions on the column values here. We
-      // cannot simply use memcpy in this case, every column has to be
-      // processed separately.
-      const uint8_t* row = m_elementData.data();
-      const uint8_t* end = m_elementData.data() + m_elementData.size();
-      uint8_t* to = reinterpret_cast<uint8_t*>(dest);
-      size_t colBytes = kPLYPropertySize[uint32_t(destType)]; // size of an output column in bytes.
-      while (row < end) {
-        for (uint32_t i = 0; i < numProps; i++) {
-          uint32_t propIdx = propIdxs[i];
-          const PLYProperty& prop = elem->properties[propIdx];
-          copy_and_convert(to, destType, row + prop.offset, prop.type);
-          to += colBytes;
-        }
-        row += elem->rowStride;
-      }
+
+    const PLYElement* elem = element();
+    if (propIdx >= elem->properties.size() || elem->properties[propIdx].countType == PLYPropertyType::None) {
+      return false;
     }
 
+    m_destinations.push_back(Destination());
+    Destination& destination = m_destinations.back();
+    destination.propIdxs.assign(1, propIdx);
+    destination.type = destType;
+    destination.data = reinterpret_cast<uint8_t*>(dest);
+    destination.listSize = listSize;
     return true;
   }
 
@@ -1053,7 +2295,7 @@ namespace miniply {
       return 0;
     }
 
-    const uint32_t numRows = element()->count;
+    const uint32_t numRows = m_numLoadedRows;
     uint32_t num = 0;
     for (uint32_t i = 0; i < numRows; i++) {
       if (counts[i] >= 3) {
@@ -1071,7 +2313,7 @@ namespace miniply {
       return false;
     }
 
-    const uint32_t numRows = element()->count;
+    const uint32_t numRows = m_numLoadedRows;
     for (uint32_t i = 0; i < numRows; i++) {
       if (counts[i] != 3) {
         return true;
@@ -1083,87 +2325,108 @@ namespace miniply {
 
   bool PLYReader::extract_triangles(uint32_t propIdx, const float pos[], uint32_t numVerts, PLYPropertyType destType, void *dest) const
   {
-    if (!requires_triangulation(propIdx)) {
-      return extract_list_property(propIdx, destType, dest);
+    const uint32_t* counts = get_list_counts(propIdx);
+    if (counts == nullptr) {
+      return false;
     }
 
     const PLYElement* elem = element();
     const PLYProperty& prop = elem->properties[propIdx];
+    const uint8_t* data = prop.listData.data();
 
-    const uint32_t* counts = prop.rowCount.data();
-    const uint8_t*  data   = prop.listData.data();
-
-    uint8_t* to = reinterpret_cast<uint8_t*>(dest);
-
-    bool convertSrc = !compatible_types(elem->properties[propIdx].type, PLYPropertyType::Int);
-    bool convertDst = !compatible_types(PLYPropertyType::Int, destType);
-
-    size_t srcValBytes  = kPLYPropertySize[uint32_t(prop.type)];
-    size_t destValBytes = kPLYPropertySize[uint32_t(destType)];
-
-    if (convertSrc && convertDst) {
-      std::vector<int> faceIndices, triIndices;
-      faceIndices.reserve(32);
-      triIndices.reserve(64);
-      const uint8_t* face = data;
-      for (uint32_t faceIdx = 0; faceIdx < elem->count; faceIdx++) {
-        const uint8_t* faceEnd = face + srcValBytes * counts[faceIdx];
-        faceIndices.clear();
-        faceIndices.reserve(counts[faceIdx]);
-        for (; face < faceEnd; face += srcValBytes) {
-          int idx = -1;
-          copy_and_convert_to(&idx, face, prop.type);
-          faceIndices.push_back(idx);
-        }
+    ColumnKernel srcKernel = column_kernel(PLYPropertyType::Int, prop.type);
+    ColumnKernel dstKernel = column_kernel(destType, PLYPropertyType::Int);
+    if (srcKernel == nullptr || dstKernel == nullptr) {
+      return false;
+    }
 
-        triIndices.resize((counts[faceIdx] - 2) * 3);
-        triangulate_polygon(counts[faceIdx], pos, numVerts, faceIndices.data(), triIndices.data());
-        for (int idx : triIndices) {
-          copy_and_convert(to, destType, reinterpret_cast<const uint8_t*>(&idx), PLYPropertyType::Int);
-          to += destValBytes;
+    // Split the faces into a contiguous range for each thread. The first pass
+    // counts the triangles and list values in each range; a prefix sum over
+    // those gives each range's start in the destination and in the list data.
+    const uint32_t numFaces = m_numLoadedRows;
+    const uint32_t numThreads = std::max(1u, std::min(num_worker_threads(), numFaces / kPLYMinFacesPerThread));
+    std::vector<uint32_t> firstFace(numThreads + 1);
+    std::vector<size_t> firstTri(numThreads + 1, 0);
+    std::vector<size_t> firstValue(numThreads + 1, 0);
+    std::vector<uint8_t> allTriangles(numThreads, 1);
+    for (uint32_t i = 0; i <= numThreads; i++) {
+      firstFace[i] = static_cast<uint32_t>(uint64_t(numFaces) * i / numThreads);
+    }
+
+    parallel_for(numThreads, [&](uint32_t i) {
+      size_t numTris = 0, numValues = 0;
+      bool triangles = true;
+      for (uint32_t faceIdx = firstFace[i]; faceIdx < firstFace[i + 1]; faceIdx++) {
+        const uint32_t n = counts[faceIdx];
+        numValues += n;
+        if (n >= 3) {
+          numTris += n - 2;
         }
+        triangles = triangles && (n == 3);
       }
+      firstTri[i + 1] = numTris;
+      firstValue[i + 1] = numValues;
+      allTriangles[i] = triangles ? 1 : 0;
+    });
+
+    bool requiresTriangulation = false;
+    for (uint32_t i = 0; i < numThreads; i++) {
+      firstTri[i + 1] += firstTri[i];
+      firstValue[i + 1] += firstValue[i];
+      requiresTriangulation = requiresTriangulation || !allTriangles[i];
+    }
+    if (!requiresTriangulation) {
+      return extract_list_property(propIdx, destType, dest);
     }
-    else if (convertSrc) {
-      std::vector<int> faceIndices;
-      faceIndices.reserve(32);
-      const uint8_t* face = data;
-      for (uint32_t faceIdx = 0; faceIdx < elem->count; faceIdx++) {
-        const uint8_t* faceEnd = face + srcValBytes * counts[faceIdx];
-        faceIndices.clear();
-        faceIndices.reserve(counts[faceIdx]);
-        for (; face < faceEnd; face += srcValBytes) {
-          int idx = -1;
-          copy_and_convert_to(&idx, face, prop.type);
-          faceIndices.push_back(idx);
+
+    const bool convertSrc = !compatible_types(prop.type, PLYPropertyType::Int);
+    const bool convertDst = !compatible_types(PLYPropertyType::Int, destType);
+    const size_t srcValBytes  = kPLYPropertySize[uint32_t(prop.type)];
+    const size_t destValBytes = kPLYPropertySize[uint32_t(destType)];
+
+    parallel_for(numThreads, [&](uint32_t i) {
+      PolygonScratch scratch;
+      const uint8_t* face = data + firstValue[i] * srcValBytes;
+      uint8_t* to = reinterpret_cast<uint8_t*>(dest) + firstTri[i] * 3 * destValBytes;
+      for (uint32_t faceIdx = firstFace[i]; faceIdx < firstFace[i + 1]; faceIdx++) {
+        const uint32_t n = counts[faceIdx];
+        if (n < 3) {
+          face += n * srcValBytes;
+          continue;
         }
 
-        uint32_t numTris = triangulate_polygon(counts[faceIdx], pos, numVerts, faceIndices.data(), reinterpret_cast<int*>(to));
-        to += numTris * 3 * destValBytes;
-      }
-    }
-    else if (convertDst) {
-      std::vector<int> triIndices;
-      triIndices.reserve(64);
-      const uint8_t* face = data;
-      for (uint32_t faceIdx = 0; faceIdx < elem->count; faceIdx++) {
-        triIndices.resize((counts[faceIdx] - 2) * 3);
-        triangulate_polygon(counts[faceIdx], pos, numVerts, reinterpret_cast<const int*>(face), triIndices.data());
-        for (int idx : triIndices) {
-          copy_and_convert(to, destType, reinterpret_cast<const uint8_t*>(&idx), PLYPropertyType::Int);
-          to += destValBytes;
+        const int* indices = reinterpret_cast<const int*>(face);
+        if (convertSrc) {
+          scratch.indices.resize(n);
+          srcKernel(reinterpret_cast<uint8_t*>(scratch.indices.data()), sizeof(int), face, srcValBytes, n);
+          indices = scratch.indices.data();
         }
-        face += srcValBytes * counts[faceIdx];
-      }
-    }
-    else {
-      const uint8_t* face = data;
-      for (uint32_t faceIdx = 0; faceIdx < elem->count; faceIdx++) {
-        uint32_t numTris = triangulate_polygon(counts[faceIdx], pos, numVerts, reinterpret_cast<const int*>(face), reinterpret_cast<int*>(to));
-        face += counts[faceIdx] * srcValBytes;
+
+        const uint32_t numTris = n - 2;
+        int* tris = reinterpret_cast<int*>(to);
+        if (convertDst) {
+          scratch.tris.resize(numTris * 3);
+          tris = scratch.tris.data();
+        }
+
+        // A face with out of range indices can't be ear clipped, so it gets a
+        // triangle fan instead. Every face must produce `n - 2` triangles to
+        // match the count from `num_triangles()`.
+        if (triangulate_polygon(n, pos, numVerts, indices, tris, scratch) == 0) {
+          for (uint32_t t = 0; t < numTris; t++) {
+            tris[t * 3]     = indices[0];
+            tris[t * 3 + 1] = indices[t + 1];
+            tris[t * 3 + 2] = indices[t + 2];
+          }
+        }
+
+        if (convertDst) {
+          dstKernel(to, destValBytes, reinterpret_cast<const uint8_t*>(tris), sizeof(int), numTris * 3);
+        }
+        face += n * srcValBytes;
         to += numTris * 3 * destValBytes;
       }
-    }
+    });
 
     return true;
   }
@@ -1221,22 +2484,37 @@ namespace miniply {
     // Move everything from the start of the current token onwards, to the
     // start of the read buffer.
     int64_t bufSize = static_cast<int64_t>(m_bufEnd - m_buf);
-    if (bufSize < kPLYReadBufferSize) {
-      m_buf[bufSize] = m_buf[kPLYReadBufferSize];
-      m_buf[kPLYReadBufferSize] = '\0';
-      m_bufEnd = m_buf + kPLYReadBufferSize;
+    if (bufSize < m_bufSize) {
+      m_buf[bufSize] = m_buf[m_bufSize];
+      m_buf[m_bufSize] = '\0';
+      m_bufEnd = m_buf + m_bufSize;
     }
     size_t keep = static_cast<size_t>(m_bufEnd - m_pos);
-    if (keep > 0 && m_pos > m_buf) {
-      std::memmove(m_buf, m_pos, sizeof(char) * keep);
-      m_bufOffset += static_cast<int64_t>(m_pos - m_buf);
+
+    // If the prefetcher has already filled another buffer, switch over to
+    // that one rather than copying its contents into ours.
+    size_t fetched = 0;
+    if (m_prefetcher != nullptr) {
+      char* pos = nullptr;
+      fetched = m_prefetcher->swap(&m_buf, m_pos, keep, &pos, &m_bufOffset);
+      if (fetched > 0) {
+        m_end = pos + (m_end - m_pos);
+        m_pos = pos;
+      }
     }
-    m_end = m_buf + (m_end - m_pos);
-    m_pos = m_buf;
 
-    // Fill the remaining space in the buffer with data from the file.
-    size_t fetched = fread(m_buf + keep, sizeof(char), kPLYReadBufferSize - keep, m_f) + keep;
-    m_atEOF = fetched < kPLYReadBufferSize;
+    if (fetched == 0) {
+      if (keep > 0 && m_pos > m_buf) {
+        std::memmove(m_buf, m_pos, sizeof(char) * keep);
+        m_bufOffset += static_cast<int64_t>(m_pos - m_buf);
+      }
+      m_end = m_buf + (m_end - m_pos);
+      m_pos = m_buf;
+
+      // Fill the remaining space in the buffer with data from the file.
+      fetched = read_file(m_buf + keep, m_bufSize - keep) + keep;
+    }
+    m_atEOF = fetched < m_bufSize;
     m_bufEnd = m_buf + fetched;
 
     if (!m_inDataSection || m_fileType == PLYFileType::ASCII) {
@@ -1266,7 +2544,7 @@ namespace miniply {
         return false;
       }
       ++safe;
-      m_buf[kPLYReadBufferSize] = *safe;
+      m_buf[m_bufSize] = *safe;
       m_bufEnd = safe;
     }
     m_buf[m_bufEnd - m_buf] = '\0';
@@ -1275,6 +2553,26 @@ namespace miniply {
   }
 
 
+  size_t PLYReader::read_file(char* dst, size_t numBytes)
+  {
+    if (m_prefetcher != nullptr) {
+      return m_prefetcher->read(dst, numBytes);
+    }
+    return fread(dst, sizeof(char), numBytes, m_f);
+  }
+
+
+  void PLYReader::seek_file(int64_t offset)
+  {
+    if (m_prefetcher != nullptr) {
+      m_prefetcher->seek(offset);
+    }
+    else {
+      file_seek(m_f, offset, SEEK_SET);
+    }
+  }
+
+
   bool PLYReader::accept()
   {
     m_pos = m_end;
@@ -1477,80 +2775,101 @@ namespace miniply {
   }
 
 
-  bool PLYReader::load_fixed_size_element(PLYElement& elem)
+  // Loads the next `numRows` rows of `elem`, replacing any rows that were
+  // loaded before.
+  bool PLYReader::load_rows(PLYElement& elem, uint32_t numRows)
   {
-    size_t numBytes = elem.count * elem.rowStride;
-
-    m_elementData.resize(numBytes);
+    // Staged list items only ever hold the current rows. Clearing them keeps
+    // their capacity, so the storage is reused from one block to the next.
+    for (PLYProperty& prop : elem.properties) {
+      prop.listData.clear();
+      prop.rowCount.clear();
+    }
 
+    bool ok;
     if (m_fileType == PLYFileType::ASCII) {
-      size_t back = 0;
-
-      for (uint32_t row = 0; row < elem.count; row++) {
-        for (PLYProperty& prop : elem.properties) {
-          if (!load_ascii_scalar_property(prop, back)) {
-            m_valid = false;
-            return false;
-          }
-        }
-        next_line();
+      ok = load_ascii_element(elem, numRows);
+    }
+    else if (!m_destinations.empty()) {
+      // Rows can be decoded in blocks if a whole row is sure to fit in the
+      // read buffer after a refill, otherwise we decode one value at a time.
+      uint32_t maxRowBytes = (m_prefetcher != nullptr) ? m_bufSize - kPLYPrefetchHeadroom : m_bufSize;
+      if (elem.fixedSize && elem.rowStride <= maxRowBytes) {
+        ok = load_fixed_size_element_to_destinations(elem, numRows);
+      }
+      else {
+        ok = load_element_rows_to_destinations(elem, numRows);
       }
     }
     else {
-      uint8_t* dst = m_elementData.data();
-      uint8_t* dstEnd = dst + numBytes;
-      while (dst < dstEnd) {
-        size_t bytesAvailable = static_cast<size_t>(m_bufEnd - m_pos);
-        if (dst + bytesAvailable > dstEnd) {
-          bytesAvailable = static_cast<size_t>(dstEnd - dst);
-        }
-        std::memcpy(dst, m_pos, bytesAvailable);
-        m_pos += bytesAvailable;
-        m_end = m_pos;
-        dst += bytesAvailable;
-        if (!refill_buffer()) {
-          break;
-        }
-      }
-      if (dst < dstEnd) {
-        m_valid = false;
-        return false;
+      ok = elem.fixedSize ? load_fixed_size_element(elem, numRows) : load_variable_size_element(elem, numRows);
+    }
+    if (!ok) {
+      return false;
+    }
+
+    m_elementLoaded = true;
+    m_firstLoadedRow = m_nextRow;
+    m_numLoadedRows = numRows;
+    m_nextRow += numRows;
+    return true;
+  }
+
+
+  bool PLYReader::load_fixed_size_element(PLYElement& elem, uint32_t numRows)
+  {
+    size_t numBytes = size_t(numRows) * elem.rowStride;
+
+    // If the file is memory mapped and no endianness swap is needed, the rows
+    // can be used directly from the mapped file contents.
+    if (m_readMode == PLYReadMode::MemoryMapped && m_fileType == PLYFileType::Binary) {
+      if (numBytes > static_cast<size_t>(m_bufEnd - m_pos)) {
+        m_valid = false;
+        return false;
       }
+      m_elementRows = reinterpret_cast<const uint8_t*>(m_pos);
+      m_pos += numBytes;
+      m_end = m_pos;
+      return true;
+    }
 
-      // We assume the CPU is little endian, so if the file is big-endian we
-      // need to do an endianness swap on every data item in the block.
-      if (m_fileType == PLYFileType::BinaryBigEndian) {
-        uint8_t* data = m_elementData.data();
-        for (uint32_t row = 0; row < elem.count; row++) {
-          for (PLYProperty& prop : elem.properties) {
-            size_t numBytes = kPLYPropertySize[uint32_t(prop.type)];
-            switch (numBytes) {
-            case 2:
-              endian_swap_2(data);
-              break;
-            case 4:
-              endian_swap_4(data);
-              break;
-            case 8:
-              endian_swap_8(data);
-              break;
-            default:
-              break;
-            }
-            data += numBytes;
-          }
-        }
+    m_elementData.resize(numBytes);
+    m_elementRows = m_elementData.data();
+
+    uint8_t* dst = m_elementData.data();
+    uint8_t* dstEnd = dst + numBytes;
+    while (dst < dstEnd) {
+      size_t bytesAvailable = static_cast<size_t>(m_bufEnd - m_pos);
+      if (dst + bytesAvailable > dstEnd) {
+        bytesAvailable = static_cast<size_t>(dstEnd - dst);
       }
+      std::memcpy(dst, m_pos, bytesAvailable);
+      m_pos += bytesAvailable;
+      m_end = m_pos;
+      dst += bytesAvailable;
+      if (!refill_buffer()) {
+        break;
+      }
+    }
+    if (dst < dstEnd) {
+      m_valid = false;
+      return false;
+    }
+
+    // We assume the CPU is little endian, so if the file is big-endian we
+    // need to do an endianness swap on every data item in the block.
+    if (m_fileType == PLYFileType::BinaryBigEndian) {
+      endian_swap_rows(m_elementData.data(), elem, numRows);
     }
 
-    m_elementLoaded = true;
     return true;
   }
 
 
-  bool PLYReader::load_variable_size_element(PLYElement& elem)
+  bool PLYReader::load_variable_size_element(PLYElement& elem, uint32_t numRows)
   {
-    m_elementData.resize(elem.count * elem.rowStride);
+    m_elementData.resize(size_t(numRows) * elem.rowStride);
+    m_elementRows = m_elementData.data();
 
     // Preallocate enough space for each row in the property to contain three
     // items. This is based on the assumptions that (a) the most common use for
@@ -1559,96 +2878,467 @@ namespace miniply {
     // listData vector as many times during loading.
     for (PLYProperty& prop : elem.properties) {
       if (prop.countType != PLYPropertyType::None) {
-        prop.listData.reserve(elem.count * kPLYPropertySize[uint32_t(prop.type)] * 3);
+        prop.listData.reserve(size_t(numRows) * kPLYPropertySize[uint32_t(prop.type)] * 3);
       }
     }
 
-    if (m_fileType == PLYFileType::Binary) {
-      size_t back = 0;
-      for (uint32_t row = 0; row < elem.count; row++) {
-        for (PLYProperty& prop : elem.properties) {
-          if (prop.countType == PLYPropertyType::None) {
-            m_valid = load_binary_scalar_property(prop, back);
-          }
-          else {
+    // Values are copied across exactly as they are in the file. For a
+    // big-endian file we swap them all afterwards, a whole block of rows or a
+    // whole list property at a time, rather than one value at a time.
+    size_t back = 0;
+    for (uint32_t row = 0; row < numRows; row++) {
+      for (PLYProperty& prop : elem.properties) {
+        bool ok = (prop.countType == PLYPropertyType::None) ?
+            load_binary_scalar_property(prop, back) :
             load_binary_list_property(prop);
-          }
+        if (!ok) {
+          return false;
         }
       }
     }
-    else if (m_fileType == PLYFileType::ASCII) {
-      size_t back = 0;
-      for (uint32_t row = 0; row < elem.count; row++) {
-        for (PLYProperty& prop : elem.properties) {
-          if (prop.countType == PLYPropertyType::None) {
-            m_valid = load_ascii_scalar_property(prop, back);
-          }
-          else {
-            load_ascii_list_property(prop);
-          }
+
+    if (m_fileType == PLYFileType::BinaryBigEndian) {
+      endian_swap_rows(m_elementData.data(), elem, numRows);
+      for (PLYProperty& prop : elem.properties) {
+        if (prop.countType != PLYPropertyType::None) {
+          endian_swap_array(prop.listData.data(), prop.type, prop.listData.size() / kPLYPropertySize[uint32_t(prop.type)]);
         }
-        next_line();
       }
     }
-    else { // m_fileType == PLYFileType::BinaryBigEndian
-      size_t back = 0;
-      for (uint32_t row = 0; row < elem.count; row++) {
-        for (PLYProperty& prop : elem.properties) {
-          if (prop.countType == PLYPropertyType::None) {
-            m_valid = load_binary_scalar_property_big_endian(prop, back);
-          }
-          else {
-            load_binary_list_property_big_endian(prop);
-          }
+
+    return m_valid;
+  }
+
+
+  bool PLYReader::load_fixed_size_element_to_destinations(PLYElement& elem, uint32_t numRowsTotal)
+  {
+    // Decode all of the whole rows that are available in the read buffer in
+    // one go, straight into the destinations. For a big-endian file the rows
+    // are swapped in a scratch buffer first, as we can't modify a memory
+    // mapped file.
+    const size_t maxSwapRows = m_bufSize / elem.rowStride;
+    if (m_fileType == PLYFileType::BinaryBigEndian) {
+      m_elementData.resize(maxSwapRows * elem.rowStride);
+    }
+
+    size_t row = 0;
+    while (row < numRowsTotal) {
+      size_t numRows = static_cast<size_t>(m_bufEnd - m_pos) / elem.rowStride;
+      if (numRows == 0) {
+        m_end = m_pos;
+        if (!refill_buffer() || static_cast<size_t>(m_bufEnd - m_pos) < elem.rowStride) {
+          m_valid = false;
+          return false;
+        }
+        continue;
+      }
+      if (numRows > numRowsTotal - row) {
+        numRows = numRowsTotal - row;
+      }
+
+      const uint8_t* rows = reinterpret_cast<const uint8_t*>(m_pos);
+      if (m_fileType == PLYFileType::BinaryBigEndian) {
+        if (numRows > maxSwapRows) {
+          numRows = maxSwapRows;
         }
+        std::memcpy(m_elementData.data(), rows, numRows * elem.rowStride);
+        endian_swap_rows(m_elementData.data(), elem, numRows);
+        rows = m_elementData.data();
+      }
+
+      for (const Destination& destination : m_destinations) {
+        const uint32_t numProps = static_cast<uint32_t>(destination.propIdxs.size());
+        const size_t destRowBytes = numProps * kPLYPropertySize[uint32_t(destination.type)];
+        extract_rows(elem, rows, numRows, destination.propIdxs.data(), numProps, destination.type,
+                     destination.data + row * destRowBytes);
       }
+
+      m_pos += numRows * elem.rowStride;
+      m_end = m_pos;
+      row += numRows;
     }
 
-    m_elementLoaded = true;
     return true;
   }
 
 
-  bool PLYReader::load_ascii_scalar_property(PLYProperty& prop, size_t& destIndex)
+  bool PLYReader::load_element_rows_to_destinations(PLYElement& elem, uint32_t numRows)
   {
+    std::vector<std::vector<Column>> columns;
+    destination_columns(elem, columns);
+
     uint8_t value[8];
-    if (!ascii_value(prop.type, value)) {
-      return false;
+    for (uint32_t row = 0; row < numRows; row++) {
+      for (uint32_t propIdx = 0, endIdx = uint32_t(elem.properties.size()); propIdx < endIdx; propIdx++) {
+        const PLYProperty& prop = elem.properties[propIdx];
+        const std::vector<Column>& cols = columns[propIdx];
+
+        if (prop.countType == PLYPropertyType::None) {
+          if (!binary_value(prop.type, value)) {
+            m_valid = false;
+            return false;
+          }
+          for (const Column& col : cols) {
+            copy_and_convert(col.data + row * col.rowStride, col.type, value, prop.type);
+          }
+          continue;
+        }
+
+        int count = 0;
+        m_valid = binary_value(prop.countType, value);
+        if (m_valid) {
+          copy_and_convert_to(&count, value, prop.countType);
+        }
+        if (!m_valid || count < 0) {
+          m_valid = false;
+          return false;
+        }
+        for (const Column& col : cols) {
+          if (uint32_t(count) != col.listSize) {
+            m_valid = false;
+            return false;
+          }
+        }
+
+        // The whole list must fit in the read buffer, so we can decode it
+        // straight from there. If nobody wants the list, we simply skip it.
+        const size_t valueBytes = kPLYPropertySize[uint32_t(prop.type)];
+        const size_t listBytes = valueBytes * uint32_t(count);
+        if (m_pos + listBytes > m_bufEnd) {
+          if (!refill_buffer() || m_pos + listBytes > m_bufEnd) {
+            m_valid = false;
+            return false;
+          }
+        }
+        const uint8_t* list = reinterpret_cast<const uint8_t*>(m_pos);
+        for (const Column& col : cols) {
+          uint8_t* to = col.data + row * col.rowStride;
+          if (m_fileType == PLYFileType::Binary && compatible_types(prop.type, col.type)) {
+            std::memcpy(to, list, listBytes);
+            continue;
+          }
+          const size_t toBytes = kPLYPropertySize[uint32_t(col.type)];
+          for (const uint8_t* from = list; from < list + listBytes; from += valueBytes, to += toBytes) {
+            std::memcpy(value, from, valueBytes);
+            if (m_fileType == PLYFileType::BinaryBigEndian) {
+              endian_swap(value, prop.type);
+            }
+            copy_and_convert(to, col.type, value, prop.type);
+          }
+        }
+        m_pos += listBytes;
+        m_end = m_pos;
+      }
     }
 
-    size_t numBytes = kPLYPropertySize[uint32_t(prop.type)];
-    std::memcpy(m_elementData.data() + destIndex, value, numBytes);
-    destIndex += numBytes;
     return true;
   }
 
 
-  bool PLYReader::load_ascii_list_property(PLYProperty& prop)
+  bool PLYReader::load_ascii_element(PLYElement& elem, uint32_t numRows)
   {
-    int count = 0;
-    m_valid = (prop.countType < PLYPropertyType::Float) && int_literal(&count) && advance() && (count >= 0);
-    if (!m_valid) {
-      return false;
+    // Values go either to the registered destinations, or to the staged
+    // element data. Staged list items are collected separately by each worker
+    // and appended to the list properties afterwards, in order.
+    std::vector<std::vector<Column>> columns;
+    const bool staged = m_destinations.empty();
+    if (staged) {
+      m_elementData.resize(size_t(numRows) * elem.rowStride);
+      m_elementRows = m_elementData.data();
+      columns.resize(elem.properties.size());
+      for (size_t propIdx = 0, endIdx = elem.properties.size(); propIdx < endIdx; propIdx++) {
+        const PLYProperty& prop = elem.properties[propIdx];
+        if (prop.countType == PLYPropertyType::None) {
+          Column col;
+          col.data = m_elementData.data() + prop.offset;
+          col.rowStride = elem.rowStride;
+          col.type = prop.type;
+          columns[propIdx].push_back(col);
+        }
+      }
+    }
+    else {
+      destination_columns(elem, columns);
     }
 
-    const size_t numBytes = kPLYPropertySize[uint32_t(prop.type)];
+    const uint32_t maxThreads = num_worker_threads();
+    std::vector<const char*> chunkStarts;
+    std::vector<const char*> chunkEnds;
+    std::vector<uint32_t> chunkRows;
+    std::vector<std::vector<PLYProperty>> chunkLists;
 
-    size_t back = prop.listData.size();
-    prop.rowCount.push_back(static_cast<uint32_t>(count));
-    prop.listData.resize(back + numBytes * size_t(count));
+    uint32_t row = 0;
+    while (row < numRows) {
+      // Work on the complete lines in the buffer. If the last line of the file
+      // doesn't end with a newline, it's complete once we're at EOF.
+      const char* blockEnd = ascii_block_end(m_pos, m_bufEnd, kPLYAsciiBlockSize);
+      if (blockEnd == m_pos) {
+        m_end = m_pos;
+        if (refill_buffer()) {
+          continue;
+        }
+        if (!m_atEOF || m_pos == m_bufEnd) {
+          m_valid = false;
+          return false;
+        }
+        blockEnd = m_bufEnd;
+      }
 
-    for (uint32_t i = 0; i < uint32_t(count); i++) {
-      if (!ascii_value(prop.type, prop.listData.data() + back)) {
-        m_valid = false;
-        return false;
+      // Don't go past the rows that were asked for, so loading a few rows at
+      // a time only ever touches those rows.
+      const uint32_t remainingRows = numRows - row;
+      blockEnd = ascii_rows_end(m_pos, blockEnd, remainingRows);
+      const size_t blockBytes = static_cast<size_t>(blockEnd - m_pos);
+      uint32_t numThreads = static_cast<uint32_t>(blockBytes / kPLYMinAsciiBytesPerThread) + 1;
+      if (numThreads > remainingRows / kPLYMinAsciiRowsPerThread + 1) {
+        numThreads = remainingRows / kPLYMinAsciiRowsPerThread + 1;
+      }
+      if (numThreads > maxThreads) {
+        numThreads = maxThreads;
+      }
+
+      if (numThreads == 1) {
+        uint32_t numRows = 0;
+        const char* pos = parse_ascii_rows(elem, columns, staged ? &elem.properties : nullptr, m_pos, blockEnd,
+                                           row, remainingRows, &numRows);
+        if (pos == nullptr) {
+          m_valid = false;
+          return false;
+        }
+        m_pos = pos;
+        m_end = m_pos;
+        row += numRows;
+        continue;
+      }
+
+      // Split the block into chunks at line boundaries and count the rows in
+      // each chunk, so that every worker knows which row it starts at.
+      chunkStarts.assign(numThreads, blockEnd);
+      chunkEnds.assign(numThreads, blockEnd);
+      chunkRows.assign(numThreads, 0);
+      chunkStarts[0] = m_pos;
+      for (uint32_t i = 1; i < numThreads; i++) {
+        const char* split = m_pos + blockBytes / numThreads * i;
+        if (split < chunkStarts[i - 1]) {
+          split = chunkStarts[i - 1];
+        }
+        chunkStarts[i] = skip_line(split, blockEnd);
+        chunkEnds[i - 1] = chunkStarts[i];
+      }
+      parallel_for(numThreads, [&](uint32_t i) {
+        chunkRows[i] = count_ascii_rows(chunkStarts[i], chunkEnds[i]);
+      });
+
+      // Convert the row counts to a prefix sum of first rows, dropping any
+      // rows past the end of this element.
+      std::vector<uint32_t> firstRows(numThreads, 0);
+      uint32_t blockRows = 0;
+      for (uint32_t i = 0; i < numThreads; i++) {
+        firstRows[i] = row + blockRows;
+        if (chunkRows[i] > remainingRows - blockRows) {
+          chunkRows[i] = remainingRows - blockRows;
+        }
+        blockRows += chunkRows[i];
+      }
+
+      if (staged) {
+        chunkLists.resize(numThreads);
+        for (std::vector<PLYProperty>& lists : chunkLists) {
+          lists.resize(elem.properties.size());
+          for (PLYProperty& list : lists) {
+            list.listData.clear();
+            list.rowCount.clear();
+          }
+        }
+      }
+
+      // Each worker records its own result, which we check once they've all
+      // finished.
+      std::vector<uint8_t> chunkValid(numThreads, 0);
+      parallel_for(numThreads, [&](uint32_t i) {
+        uint32_t numRows = 0;
+        const char* pos = parse_ascii_rows(elem, columns, staged ? &chunkLists[i] : nullptr, chunkStarts[i],
+                                           chunkEnds[i], firstRows[i], chunkRows[i], &numRows);
+        chunkValid[i] = (pos != nullptr && numRows == chunkRows[i]) ? 1 : 0;
+        chunkEnds[i] = pos;
+      });
+      for (uint32_t i = 0; i < numThreads; i++) {
+        if (!chunkValid[i]) {
+          m_valid = false;
+          return false;
+        }
+      }
+
+      if (staged) {
+        // Append the staged list items from each worker, at offsets given by
+        // a prefix sum over the number of items per worker.
+        std::vector<size_t> rowOffsets(numThreads * elem.properties.size());
+        std::vector<size_t> byteOffsets(numThreads * elem.properties.size());
+        for (size_t propIdx = 0, endIdx = elem.properties.size(); propIdx < endIdx; propIdx++) {
+          PLYProperty& prop = elem.properties[propIdx];
+          if (prop.countType == PLYPropertyType::None) {
+            continue;
+          }
+          size_t numRows = prop.rowCount.size();
+          size_t numBytes = prop.listData.size();
+          for (uint32_t i = 0; i < numThreads; i++) {
+            rowOffsets[i * endIdx + propIdx] = numRows;
+            byteOffsets[i * endIdx + propIdx] = numBytes;
+            numRows += chunkLists[i][propIdx].rowCount.size();
+            numBytes += chunkLists[i][propIdx].listData.size();
+          }
+          prop.rowCount.resize(numRows);
+          prop.listData.resize(numBytes);
+        }
+        parallel_for(numThreads, [&](uint32_t i) {
+          for (size_t propIdx = 0, endIdx = elem.properties.size(); propIdx < endIdx; propIdx++) {
+            PLYProperty& prop = elem.properties[propIdx];
+            const PLYProperty& list = chunkLists[i][propIdx];
+            if (prop.countType == PLYPropertyType::None || list.rowCount.empty()) {
+              continue;
+            }
+            std::memcpy(prop.rowCount.data() + rowOffsets[i * endIdx + propIdx], list.rowCount.data(),
+                        list.rowCount.size() * sizeof(uint32_t));
+            if (!list.listData.empty()) {
+              std::memcpy(prop.listData.data() + byteOffsets[i * endIdx + propIdx], list.listData.data(),
+                          list.listData.size());
+            }
+          }
+        });
+      }
+
+      // Continue after the last row that we parsed. If there were no rows in
+      // the block at all, it was nothing but comments.
+      m_pos = blockEnd;
+      for (uint32_t i = numThreads; i > 0; i--) {
+        if (chunkRows[i - 1] > 0) {
+          m_pos = chunkEnds[i - 1];
+          break;
+        }
       }
-      back += numBytes;
+      m_end = m_pos;
+      row += blockRows;
+    }
+
+    // Skip any comments after the last row, as `next_line()` would.
+    if (match("comment") || match("obj_info")) {
+      next_line();
     }
+    m_end = m_pos;
 
     return true;
   }
 
 
+  void PLYReader::destination_columns(const PLYElement& elem, std::vector<std::vector<Column>>& columns) const
+  {
+    columns.clear();
+    columns.resize(elem.properties.size());
+    for (const Destination& destination : m_destinations) {
+      const size_t valueBytes = kPLYPropertySize[uint32_t(destination.type)];
+      if (destination.listSize > 0) {
+        Column col;
+        col.data = destination.data;
+        col.rowStride = valueBytes * destination.listSize;
+        col.type = destination.type;
+        col.listSize = destination.listSize;
+        columns[destination.propIdxs[0]].push_back(col);
+        continue;
+      }
+      for (size_t i = 0, endI = destination.propIdxs.size(); i < endI; i++) {
+        Column col;
+        col.data = destination.data + i * valueBytes;
+        col.rowStride = valueBytes * endI;
+        col.type = destination.type;
+        columns[destination.propIdxs[i]].push_back(col);
+      }
+    }
+  }
+
+
+  // Parses up to `maxRows` rows of ASCII element data from the lines between
+  // `pos` and `end` into `columns`, where the first of them is row `firstRow`
+  // of the element. Items of list properties without a column are appended to
+  // the matching property in `lists`, unless it's null. This doesn't touch
+  // any reader state, so several workers can parse different parts of an
+  // element at the same time. Returns the position after the last row parsed,
+  // or null if the data is malformed.
+  const char* PLYReader::parse_ascii_rows(const PLYElement& elem, const std::vector<std::vector<Column>>& columns,
+                                          std::vector<PLYProperty>* lists, const char* pos, const char* end,
+                                          uint32_t firstRow, uint32_t maxRows, uint32_t* numRows)
+  {
+    uint8_t value[8];
+    uint32_t rowsParsed = 0;
+    while (rowsParsed < maxRows) {
+      while (pos < end && is_comment_line(pos, end)) {
+        pos = skip_line(pos, end);
+      }
+      if (pos == end) {
+        break;
+      }
+
+      const size_t row = size_t(firstRow) + rowsParsed;
+      for (uint32_t propIdx = 0, endIdx = uint32_t(elem.properties.size()); propIdx < endIdx; propIdx++) {
+        const PLYProperty& prop = elem.properties[propIdx];
+        const std::vector<Column>& cols = columns[propIdx];
+
+        while (is_whitespace(*pos)) {
+          ++pos;
+        }
+        if (prop.countType == PLYPropertyType::None) {
+          if (!ascii_value(pos, &pos, prop.type, value)) {
+            return nullptr;
+          }
+          for (const Column& col : cols) {
+            copy_and_convert(col.data + row * col.rowStride, col.type, value, prop.type);
+          }
+          continue;
+        }
+
+        int count = 0;
+        if (prop.countType >= PLYPropertyType::Float || !miniply::int_literal(pos, &pos, &count) || count < 0) {
+          return nullptr;
+        }
+        for (const Column& col : cols) {
+          if (uint32_t(count) != col.listSize) {
+            return nullptr;
+          }
+        }
+
+        const size_t numBytes = kPLYPropertySize[uint32_t(prop.type)];
+        uint8_t* staged = nullptr;
+        if (lists != nullptr) {
+          PLYProperty& list = (*lists)[propIdx];
+          size_t back = list.listData.size();
+          list.rowCount.push_back(static_cast<uint32_t>(count));
+          list.listData.resize(back + numBytes * size_t(count));
+          staged = list.listData.data() + back;
+        }
+        for (uint32_t i = 0; i < uint32_t(count); i++) {
+          while (is_whitespace(*pos)) {
+            ++pos;
+          }
+          if (!ascii_value(pos, &pos, prop.type, value)) {
+            return nullptr;
+          }
+          if (staged != nullptr) {
+            std::memcpy(staged + i * numBytes, value, numBytes);
+          }
+          for (const Column& col : cols) {
+            copy_and_convert(col.data + row * col.rowStride + i * kPLYPropertySize[uint32_t(col.type)], col.type, value, prop.type);
+          }
+        }
+      }
+
+      pos = skip_line(pos, end);
+      rowsParsed++;
+    }
+
+    *numRows = rowsParsed;
+    return pos;
+  }
+
+
   bool PLYReader::load_binary_scalar_property(PLYProperty& prop, size_t& destIndex)
   {
     size_t numBytes = kPLYPropertySize[uint32_t(prop.type)];
@@ -1676,9 +3366,7 @@ namespace miniply {
       }
     }
 
-    int count = 0;
-    copy_and_convert_to(&count, reinterpret_cast<const uint8_t*>(m_pos), prop.countType);
-
+    int count = binary_list_count(m_pos, prop.countType, m_fileType == PLYFileType::BinaryBigEndian);
     if (count < 0) {
       m_valid = false;
       return false;
@@ -1705,224 +3393,677 @@ namespace miniply {
   }
 
 
-  bool PLYReader::load_binary_scalar_property_big_endian(PLYProperty &prop, size_t &destIndex)
+  bool PLYReader::binary_value(PLYPropertyType propType, uint8_t value[8])
   {
-    size_t startIndex = destIndex;
-    if (load_binary_scalar_property(prop, destIndex)) {
-      endian_swap(m_elementData.data() + startIndex, prop.type);
-      return true;
+    size_t numBytes = kPLYPropertySize[uint32_t(propType)];
+    if (m_pos + numBytes > m_bufEnd) {
+      if (!refill_buffer() || m_pos + numBytes > m_bufEnd) {
+        m_valid = false;
+        return false;
+      }
     }
-    else {
-      return false;
+    std::memcpy(value, m_pos, numBytes);
+    if (m_fileType == PLYFileType::BinaryBigEndian) {
+      endian_swap(value, propType);
     }
+    m_pos += numBytes;
+    m_end = m_pos;
+    return true;
   }
 
 
-  bool PLYReader::load_binary_list_property_big_endian(PLYProperty &prop)
+  //
+  // Header probing
+  //
+
+  // These follow the same grammar as the `PLYReader` header parsing methods,
+  // but work on a null-terminated string which holds the whole header.
+
+  static inline const char* skip_whitespace(const char* pos)
   {
-    size_t countBytes = kPLYPropertySize[uint32_t(prop.countType)];
-    if (m_pos + countBytes > m_bufEnd) {
-      if (!refill_buffer() || m_pos + countBytes > m_bufEnd) {
-        m_valid = false;
-        return false;
-      }
+    while (is_whitespace(*pos)) {
+      ++pos;
     }
+    return pos;
+  }
 
-    int count = 0;
-    uint8_t tmp[8];
-    std::memcpy(tmp, m_pos, countBytes);
-    endian_swap(tmp, prop.countType);
-    copy_and_convert_to(&count, tmp, prop.countType);
 
-    if (count < 0) {
-      m_valid = false;
-      return false;
+  // Returns a pointer to the line after the `end_header` line, or nullptr if
+  // there isn't a complete one in `buf`.
+  static const char* find_header_end(const char* buf)
+  {
+    for (const char* line = buf; *line != '\0'; ) {
+      const char* newline = std::strchr(line, '\n');
+      if (newline == nullptr) {
+        break;
+      }
+      if (starts_with(line, newline, "end_header")) {
+        return newline + 1;
+      }
+      line = newline + 1;
     }
+    return nullptr;
+  }
 
-    m_pos += countBytes;
-    m_end = m_pos;
 
-    const size_t typeBytes = kPLYPropertySize[uint32_t(prop.type)];
-    const size_t listBytes = typeBytes * uint32_t(count);
-    if (m_pos + listBytes > m_bufEnd) {
-      if (!refill_buffer() || m_pos + listBytes > m_bufEnd) {
-        m_valid = false;
+  static bool probe_next_line(const char** pos)
+  {
+    const char* newline = std::strchr(*pos, '\n');
+    if (newline == nullptr) {
+      return false;
+    }
+    *pos = newline + 1;
+    while (std::strncmp(*pos, "comment", 7) == 0 || std::strncmp(*pos, "obj_info", 8) == 0) {
+      newline = std::strchr(*pos, '\n');
+      if (newline == nullptr) {
         return false;
       }
+      *pos = newline + 1;
     }
-    size_t back = prop.listData.size();
-    prop.rowCount.push_back(static_cast<uint32_t>(count));
-    prop.listData.resize(back + listBytes);
+    return true;
+  }
 
-    uint8_t* list = prop.listData.data() + back;
-    std::memcpy(list, m_pos, listBytes);
-    endian_swap_array(list, prop.type, count);
 
-    m_pos += listBytes;
-    m_end = m_pos;
+  // Matches `kw` as a whole keyword, then skips any whitespace after it.
+  static bool probe_keyword(const char** pos, const char* kw)
+  {
+    const char* end = *pos;
+    while (*kw != '\0' && *end == *kw) {
+      ++end;
+      ++kw;
+    }
+    if (*kw != '\0' || is_keyword_part(*end)) {
+      return false;
+    }
+    *pos = skip_whitespace(end);
     return true;
   }
 
 
-  bool PLYReader::ascii_value(PLYPropertyType propType, uint8_t value[8])
+  static bool probe_char(const char** pos, char ch)
   {
-    int tmpInt = 0;
-
-    switch (propType) {
-    case PLYPropertyType::Char:
-    case PLYPropertyType::UChar:
-    case PLYPropertyType::Short:
-    case PLYPropertyType::UShort:
-      m_valid = int_literal(&tmpInt);
-      break;
-    case PLYPropertyType::Int:
-    case PLYPropertyType::UInt:
-      m_valid = int_literal(reinterpret_cast<int*>(value));
-      break;
-    case PLYPropertyType::Float:
-      m_valid = float_literal(reinterpret_cast<float*>(value));
-      break;
-    case PLYPropertyType::Double:
-    default:
-      m_valid = double_literal(reinterpret_cast<double*>(value));
-      break;
+    if (**pos != ch) {
+      return false;
     }
+    *pos = skip_whitespace(*pos + 1);
+    return true;
+  }
 
-    if (!m_valid) {
+
+  static bool probe_identifier(const char** pos, std::string& dest)
+  {
+    const char* end = *pos;
+    if (!is_keyword_start(*end)) {
       return false;
     }
-    advance();
+    do {
+      ++end;
+    } while (is_keyword_part(*end));
+    dest.assign(*pos, end);
+    *pos = skip_whitespace(end);
+    return true;
+  }
 
-    switch (propType) {
-    case PLYPropertyType::Char:
-      reinterpret_cast<int8_t*>(value)[0] = static_cast<int8_t>(tmpInt);
-      break;
-    case PLYPropertyType::UChar:
-      value[0] = static_cast<uint8_t>(tmpInt);
-      break;
-    case PLYPropertyType::Short:
-      reinterpret_cast<int16_t*>(value)[0] = static_cast<int16_t>(tmpInt);
-      break;
-    case PLYPropertyType::UShort:
-      reinterpret_cast<uint16_t*>(value)[0] = static_cast<uint16_t>(tmpInt);
-      break;
-    default:
-      break;
+
+  static bool probe_int(const char** pos, int* value)
+  {
+    const char* end = nullptr;
+    if (!int_literal(*pos, &end, value)) {
+      return false;
+    }
+    *pos = skip_whitespace(end);
+    return true;
+  }
+
+
+  static bool probe_property_type(const char** pos, PLYPropertyType* type)
+  {
+    for (uint32_t i = 0; kTypeAliases[i].name != nullptr; i++) {
+      if (probe_keyword(pos, kTypeAliases[i].name)) {
+        *type = kTypeAliases[i].type;
+        return true;
+      }
+    }
+    return false;
+  }
+
+
+  static bool probe_property(const char** pos, PLYElement& elem)
+  {
+    PLYPropertyType type      = PLYPropertyType::None;
+    PLYPropertyType countType = PLYPropertyType::None;
+    if (probe_keyword(pos, "list") && !probe_property_type(pos, &countType)) {
+      return false;
+    }
+    elem.properties.push_back(PLYProperty());
+    PLYProperty& prop = elem.properties.back();
+    if (!probe_property_type(pos, &type) || !probe_identifier(pos, prop.name) || !probe_next_line(pos)) {
+      return false;
+    }
+    prop.type = type;
+    prop.countType = countType;
+    return true;
+  }
+
+
+  static bool parse_ply_header(const char* buf, PLYHeader* header)
+  {
+    const char* pos = buf;
+    if (!probe_keyword(&pos, "ply") || !probe_next_line(&pos) || !probe_keyword(&pos, "format")) {
+      return false;
+    }
+    uint32_t fileType = 0;
+    while (kPLYFileTypes[fileType] != nullptr && !probe_keyword(&pos, kPLYFileTypes[fileType])) {
+      ++fileType;
+    }
+    if (kPLYFileTypes[fileType] == nullptr ||
+        !probe_int(&pos, &header->majorVersion) || !probe_char(&pos, '.') ||
+        !probe_int(&pos, &header->minorVersion) || !probe_next_line(&pos)) {
+      return false;
+    }
+    header->fileType = static_cast<PLYFileType>(fileType);
+
+    while (probe_keyword(&pos, "element")) {
+      header->elements.push_back(PLYElement());
+      PLYElement& elem = header->elements.back();
+      int count = 0;
+      if (!probe_identifier(&pos, elem.name) || !probe_int(&pos, &count) || count < 0 || !probe_next_line(&pos)) {
+        return false;
+      }
+      elem.count = static_cast<uint32_t>(count);
+      while (probe_keyword(&pos, "property")) {
+        if (!probe_property(&pos, elem)) {
+          return false;
+        }
+      }
+      elem.calculate_offsets();
+    }
+
+    if (!probe_keyword(&pos, "end_header") || *pos != '\n') {
+      return false;
+    }
+    header->dataOffset = static_cast<uint64_t>(pos + 1 - buf);
+
+    uint64_t offset = header->dataOffset;
+    for (const PLYElement& elem : header->elements) {
+      uint64_t size = kPLYUnknownSize;
+      if (header->fileType != PLYFileType::ASCII && (elem.fixedSize || elem.count == 0)) {
+        size = uint64_t(elem.count) * elem.rowStride;
+      }
+      header->elementSizes.push_back(size);
+      header->elementOffsets.push_back(offset);
+      if (offset != kPLYUnknownSize && size != kPLYUnknownSize) {
+        offset += size;
+      }
+      else {
+        offset = kPLYUnknownSize;
+      }
     }
     return true;
   }
 
 
+  bool probe_ply(const char* filename, PLYHeader* header)
+  {
+    header->elements.clear();
+    header->elementSizes.clear();
+    header->elementOffsets.clear();
+
+    FILE* f = nullptr;
+    if (file_open(&f, filename, "rb") != 0) {
+      return false;
+    }
+    // We read straight into our own buffer, so there's no need for stdio to
+    // set up one of its own.
+    setvbuf(f, nullptr, _IONBF, 0);
+
+    // The header almost always fits into the first read, but if not we keep
+    // going, doubling the buffer size each time.
+    char smallBuf[kPLYProbeReadSize + 1];
+    std::vector<char> largeBuf;
+    char* buf = smallBuf;
+    size_t bufSize = kPLYProbeReadSize;
+    size_t size = fread(buf, sizeof(char), bufSize, f);
+    buf[size] = '\0';
+    while (size == bufSize && find_header_end(buf) == nullptr) {
+      largeBuf.resize(bufSize * 2 + 1);
+      if (buf == smallBuf) {
+        std::memcpy(largeBuf.data(), smallBuf, size);
+      }
+      buf = largeBuf.data();
+      bufSize *= 2;
+      size += fread(buf + size, sizeof(char), bufSize - size, f);
+      buf[size] = '\0';
+    }
+    fclose(f);
+
+    return parse_ply_header(buf, header);
+  }
+
+
   //
-  // Polygon triangulation
+  // PLYWriter methods
   //
 
-  static float angle_at_vert(uint32_t idx,
-                             const std::vector<Vec2>& points2D,
-                             const std::vector<uint32_t>& prev,
-                             const std::vector<uint32_t>& next)
+  PLYWriter::PLYWriter(const char* filename, PLYFileType fileType) :
+    m_fileType(fileType)
   {
-    Vec2 xaxis = normalize(points2D[next[idx]] - points2D[idx]);
-    Vec2 yaxis = Vec2{-xaxis.y, xaxis.x};
-    Vec2 p2p0 = points2D[prev[idx]] - points2D[idx];
-    float angle = std::atan2(dot(p2p0, yaxis), dot(p2p0, xaxis));
-    if (angle <= 0.0f || angle >= kPi) {
-      angle = 10000.0f;
+    if (file_open(&m_f, filename, "wb") != 0) {
+      m_f = nullptr;
+      return;
     }
-    return angle;
+    m_buf = new char[kPLYWriteBufferSize];
+    m_bufEnd = m_buf + kPLYWriteBufferSize;
+    m_pos = m_buf;
+    m_valid = true;
   }
 
 
-  uint32_t triangulate_polygon(uint32_t n, const float pos[], uint32_t numVerts, const int indices[], int dst[])
+  PLYWriter::~PLYWriter()
   {
-    if (n < 3) {
-      return 0;
+    if (m_f != nullptr) {
+      fclose(m_f);
     }
-    else if (n == 3) {
-      dst[0] = indices[0];
-      dst[1] = indices[1];
-      dst[2] = indices[2];
-      return 1;
+    delete[] m_buf;
+  }
+
+
+  bool PLYWriter::valid() const
+  {
+    return m_valid;
+  }
+
+
+  PLYFileType PLYWriter::file_type() const
+  {
+    return m_fileType;
+  }
+
+
+  bool PLYWriter::add_comment(const char* comment)
+  {
+    if (m_written || std::strchr(comment, '\n') != nullptr) {
+      return false;
     }
-    else if (n == 4) {
-      dst[0] = indices[0];
-      dst[1] = indices[1];
-      dst[2] = indices[3];
+    m_comments.push_back(comment);
+    return true;
+  }
 
-      dst[3] = indices[2];
-      dst[4] = indices[3];
-      dst[5] = indices[1];
-      return 2;
+
+  uint32_t PLYWriter::add_element(const char* name, uint32_t count)
+  {
+    if (m_written) {
+      return kInvalidIndex;
+    }
+    m_elements.push_back(PLYElement());
+    m_elements.back().name = name;
+    m_elements.back().count = count;
+    m_sources.push_back(std::vector<Source>());
+    return static_cast<uint32_t>(m_elements.size() - 1);
+  }
+
+
+  uint32_t PLYWriter::add_property(uint32_t elemIdx, const char* name, PLYPropertyType type)
+  {
+    return add_list_property(elemIdx, name, PLYPropertyType::None, type);
+  }
+
+
+  uint32_t PLYWriter::add_list_property(uint32_t elemIdx, const char* name, PLYPropertyType countType, PLYPropertyType type)
+  {
+    if (m_written || elemIdx >= m_elements.size() || type == PLYPropertyType::None ||
+        countType == PLYPropertyType::Float || countType == PLYPropertyType::Double) {
+      return kInvalidIndex;
     }
+    PLYElement& elem = m_elements[elemIdx];
+    elem.properties.push_back(PLYProperty());
+    elem.properties.back().name = name;
+    elem.properties.back().type = type;
+    elem.properties.back().countType = countType;
+    elem.properties.back().stride = kPLYPropertySize[uint32_t(type)];
+    m_sources[elemIdx].push_back(Source());
+    return static_cast<uint32_t>(elem.properties.size() - 1);
+  }
 
-    // Check that all indices for this face are in the valid range before we
-    // try to dereference them.
-    for (uint32_t i = 0; i < n; i++) {
-      if (indices[i] < 0 || uint32_t(indices[i]) >= numVerts) {
-        return 0;
+
+  uint32_t PLYWriter::num_elements() const
+  {
+    return static_cast<uint32_t>(m_elements.size());
+  }
+
+
+  const PLYElement* PLYWriter::get_element(uint32_t idx) const
+  {
+    return (idx < m_elements.size()) ? &m_elements[idx] : nullptr;
+  }
+
+
+  bool PLYWriter::set_source(uint32_t elemIdx, const uint32_t propIdxs[], uint32_t numProps, PLYPropertyType srcType, const void* src, size_t srcStride)
+  {
+    if (m_written || elemIdx >= m_elements.size() || numProps == 0 || srcType == PLYPropertyType::None || src == nullptr) {
+      return false;
+    }
+    const PLYElement& elem = m_elements[elemIdx];
+    for (uint32_t i = 0; i < numProps; i++) {
+      if (propIdxs[i] >= elem.properties.size() || elem.properties[propIdxs[i]].countType != PLYPropertyType::None) {
+        return false;
       }
     }
 
-    const Vec3* vpos = reinterpret_cast<const Vec3*>(pos);
+    const size_t valueBytes = kPLYPropertySize[uint32_t(srcType)];
+    if (srcStride == 0) {
+      srcStride = valueBytes * numProps;
+    }
+    for (uint32_t i = 0; i < numProps; i++) {
+      Source& source = m_sources[elemIdx][propIdxs[i]];
+      source = Source();
+      source.data = reinterpret_cast<const uint8_t*>(src) + i * valueBytes;
+      source.rowStride = srcStride;
+      source.type = srcType;
+    }
+    return true;
+  }
 
-    // Calculate the geometric normal of the face
-    Vec3 origin = vpos[indices[0]];
-    Vec3 faceU = normalize(vpos[indices[1]] - origin);
-    Vec3 faceNormal = normalize(cross(faceU, normalize(vpos[indices[n - 1]] - origin)));
-    Vec3 faceV = normalize(cross(faceNormal, faceU));
 
-    // Project the faces points onto the plane perpendicular to the normal.
-    std::vector<Vec2> points2D(n, Vec2{0.0f, 0.0f});
-    for (uint32_t i = 1; i < n; i++) {
-      Vec3 p = vpos[indices[i]] - origin;
-      points2D[i] = Vec2{dot(p, faceU), dot(p, faceV)};
+  bool PLYWriter::set_list_source(uint32_t elemIdx, uint32_t propIdx, uint32_t listSize, PLYPropertyType srcType, const void* src, size_t srcStride)
+  {
+    if (m_written || elemIdx >= m_elements.size() || propIdx >= m_elements[elemIdx].properties.size() ||
+        m_elements[elemIdx].properties[propIdx].countType == PLYPropertyType::None ||
+        srcType == PLYPropertyType::None || src == nullptr) {
+      return false;
     }
 
-    std::vector<uint32_t> next(n, 0u);
-    std::vector<uint32_t> prev(n, 0u);
-    uint32_t first = 0;
-    for (uint32_t i = 0, j = n - 1; i < n; i++) {
-      next[j] = i;
-      prev[i] = j;
-      j = i;
+    Source& source = m_sources[elemIdx][propIdx];
+    source = Source();
+    source.data = reinterpret_cast<const uint8_t*>(src);
+    source.rowStride = (srcStride != 0) ? srcStride : kPLYPropertySize[uint32_t(srcType)] * listSize;
+    source.type = srcType;
+    source.listSize = listSize;
+    return true;
+  }
+
+
+  bool PLYWriter::set_variable_list_source(uint32_t elemIdx, uint32_t propIdx, const uint32_t counts[], PLYPropertyType srcType, const void* src)
+  {
+    if (m_written || elemIdx >= m_elements.size() || propIdx >= m_elements[elemIdx].properties.size() ||
+        m_elements[elemIdx].properties[propIdx].countType == PLYPropertyType::None ||
+        srcType == PLYPropertyType::None || counts == nullptr || src == nullptr) {
+      return false;
     }
 
-    // Do ear clipping.
-    while (n > 3) {
-      // Find the (remaining) vertex with the sharpest angle.
-      uint32_t bestI = first;
-      float bestAngle = angle_at_vert(first, points2D, prev, next);
-      for (uint32_t i = next[first]; i != first; i = next[i]) {
-        float angle = angle_at_vert(i, points2D, prev, next);
-        if (angle < bestAngle) {
-          bestI = i;
-          bestAngle = angle;
+    Source& source = m_sources[elemIdx][propIdx];
+    source = Source();
+    source.data = reinterpret_cast<const uint8_t*>(src);
+    source.type = srcType;
+    source.counts = counts;
+    return true;
+  }
+
+
+  bool PLYWriter::write()
+  {
+    if (!m_valid || m_written) {
+      return false;
+    }
+    m_written = true;
+
+    for (size_t elemIdx = 0, endIdx = m_elements.size(); elemIdx < endIdx; elemIdx++) {
+      PLYElement& elem = m_elements[elemIdx];
+      elem.calculate_offsets();
+      if (elem.count == 0) {
+        continue;
+      }
+      for (const Source& source : m_sources[elemIdx]) {
+        if (source.data == nullptr) {
+          m_valid = false;
+          return false;
         }
       }
+    }
 
-      // Clip the triangle at bestI.
-      uint32_t nextI = next[bestI];
-      uint32_t prevI = prev[bestI];
+    if (!write_header()) {
+      return false;
+    }
+    for (size_t elemIdx = 0, endIdx = m_elements.size(); elemIdx < endIdx; elemIdx++) {
+      const PLYElement& elem = m_elements[elemIdx];
+      if (elem.count == 0) {
+        continue;
+      }
+      bool ok = (elem.fixedSize && m_fileType != PLYFileType::ASCII) ?
+                  write_fixed_size_element(elem, m_sources[elemIdx]) :
+                  write_element_rows(elem, m_sources[elemIdx]);
+      if (!ok) {
+        return false;
+      }
+    }
+    return flush() && fflush(m_f) == 0;
+  }
 
-      dst[0] = indices[bestI];
-      dst[1] = indices[nextI];
-      dst[2] = indices[prevI];
-      dst += 3;
 
-      if (bestI == first) {
-        first = nextI;
+  //
+  // PLYWriter private methods
+  //
+
+  bool PLYWriter::write_header()
+  {
+    std::string header = "ply\nformat ";
+    header += kPLYFileTypes[uint32_t(m_fileType)];
+    header += " 1.0\n";
+    for (const std::string& comment : m_comments) {
+      header += "comment ";
+      header += comment;
+      header += "\n";
+    }
+    for (const PLYElement& elem : m_elements) {
+      char countBuf[16];
+      *format_uint(countBuf, elem.count) = '\0';
+      header += "element ";
+      header += elem.name;
+      header += " ";
+      header += countBuf;
+      header += "\n";
+      for (const PLYProperty& prop : elem.properties) {
+        header += "property ";
+        if (prop.countType != PLYPropertyType::None) {
+          header += "list ";
+          header += kTypeAliases[uint32_t(prop.countType)].name;
+          header += " ";
+        }
+        header += kTypeAliases[uint32_t(prop.type)].name;
+        header += " ";
+        header += prop.name;
+        header += "\n";
       }
-      next[prevI] = nextI;
-      prev[nextI] = prevI;
-      --n;
     }
+    header += "end_header\n";
+    return write_bytes(header.data(), header.size());
+  }
 
-    // Add the final triangle.
-    dst[0] = indices[first];
-    dst[1] = indices[next[first]];
-    dst[2] = indices[prev[first]];
 
-    return n - 2;
+  bool PLYWriter::write_fixed_size_element(const PLYElement& elem, const std::vector<Source>& sources)
+  {
+    if (elem.rowStride == 0) {
+      return true; // no properties, so nothing to write.
+    }
+
+    // If the source data already has exactly the layout of the rows in the
+    // file, we can write it out directly.
+    bool sameLayout = (m_fileType == PLYFileType::Binary);
+    for (size_t propIdx = 0, endIdx = elem.properties.size(); sameLayout && propIdx < endIdx; propIdx++) {
+      const PLYProperty& prop = elem.properties[propIdx];
+      const Source& source = sources[propIdx];
+      sameLayout = compatible_types(source.type, prop.type) &&
+                   source.rowStride == elem.rowStride &&
+                   source.data == sources[0].data + prop.offset;
+    }
+    if (sameLayout) {
+      return write_bytes(sources[0].data, size_t(elem.count) * elem.rowStride);
+    }
+
+    // Otherwise fill the write buffer with as many rows as will fit, one
+    // column at a time.
+    const size_t maxRows = kPLYWriteBufferSize / elem.rowStride;
+    if (maxRows == 0) {
+      return write_element_rows(elem, sources);
+    }
+
+    size_t row = 0;
+    while (row < elem.count) {
+      size_t numRows = static_cast<size_t>(m_bufEnd - m_pos) / elem.rowStride;
+      if (numRows == 0) {
+        if (!flush()) {
+          return false;
+        }
+        continue;
+      }
+      if (numRows > elem.count - row) {
+        numRows = elem.count - row;
+      }
+
+      uint8_t* rows = reinterpret_cast<uint8_t*>(m_pos);
+      for (size_t propIdx = 0, endIdx = elem.properties.size(); propIdx < endIdx; propIdx++) {
+        const PLYProperty& prop = elem.properties[propIdx];
+        const Source& source = sources[propIdx];
+        convert_column(rows + prop.offset, elem.rowStride, prop.type,
+                       source.data + row * source.rowStride, source.rowStride, source.type, numRows);
+      }
+      if (m_fileType == PLYFileType::BinaryBigEndian) {
+        endian_swap_rows(rows, elem, numRows);
+      }
+
+      m_pos += numRows * elem.rowStride;
+      row += numRows;
+    }
+    return true;
+  }
+
+
+  bool PLYWriter::write_element_rows(const PLYElement& elem, const std::vector<Source>& sources)
+  {
+    const bool ascii = m_fileType == PLYFileType::ASCII;
+    const size_t numProps = elem.properties.size();
+
+    // The items for variable-size lists are stored back to back, so we keep
+    // track of where the next list starts for each of them.
+    std::vector<const uint8_t*> nextList(numProps);
+    for (size_t propIdx = 0; propIdx < numProps; propIdx++) {
+      nextList[propIdx] = sources[propIdx].data;
+    }
+
+    for (uint32_t row = 0; row < elem.count; row++) {
+      for (size_t propIdx = 0; propIdx < numProps; propIdx++) {
+        const PLYProperty& prop = elem.properties[propIdx];
+        const Source& source = sources[propIdx];
+
+        if (prop.countType == PLYPropertyType::None) {
+          if (!write_value(prop.type, source.data + size_t(row) * source.rowStride, source.type)) {
+            return false;
+          }
+          continue;
+        }
+
+        const uint32_t count = (source.counts != nullptr) ? source.counts[row] : source.listSize;
+        const uint8_t* list = (source.counts != nullptr) ? nextList[propIdx] : source.data + size_t(row) * source.rowStride;
+        if (!write_value(prop.countType, reinterpret_cast<const uint8_t*>(&count), PLYPropertyType::UInt)) {
+          return false;
+        }
+
+        const size_t srcBytes = kPLYPropertySize[uint32_t(source.type)];
+        if (m_fileType == PLYFileType::Binary && compatible_types(source.type, prop.type)) {
+          if (!write_bytes(list, srcBytes * count)) {
+            return false;
+          }
+        }
+        else {
+          for (uint32_t i = 0; i < count; i++) {
+            if (!write_value(prop.type, list + i * srcBytes, source.type)) {
+              return false;
+            }
+          }
+        }
+        nextList[propIdx] = list + srcBytes * count;
+      }
+
+      if (ascii && numProps > 0) {
+        // Replace the separator after the last value with a newline.
+        m_pos[-1] = '\n';
+      }
+      else if (ascii && !write_bytes("\n", 1)) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+
+  bool PLYWriter::write_value(PLYPropertyType type, const uint8_t* src, PLYPropertyType srcType)
+  {
+    if (!reserve(kPLYMaxAsciiValueLength)) {
+      return false;
+    }
+
+    if (m_fileType == PLYFileType::ASCII) {
+      uint8_t value[8];
+      copy_and_convert(value, type, src, srcType);
+      m_pos = format_ascii_value(m_pos, type, value);
+      *m_pos++ = ' ';
+      return true;
+    }
+
+    uint8_t* dest = reinterpret_cast<uint8_t*>(m_pos);
+    copy_and_convert(dest, type, src, srcType);
+    if (m_fileType == PLYFileType::BinaryBigEndian) {
+      endian_swap(dest, type);
+    }
+    m_pos += kPLYPropertySize[uint32_t(type)];
+    return true;
+  }
+
+
+  bool PLYWriter::write_bytes(const void* data, size_t numBytes)
+  {
+    // Anything that doesn't fit in the write buffer goes straight to the
+    // file, rather than being copied through the buffer in pieces.
+    if (numBytes > static_cast<size_t>(m_bufEnd - m_pos)) {
+      if (!flush()) {
+        return false;
+      }
+      if (numBytes > kPLYWriteBufferSize) {
+        m_valid = fwrite(data, sizeof(char), numBytes, m_f) == numBytes;
+        return m_valid;
+      }
+    }
+    std::memcpy(m_pos, data, numBytes);
+    m_pos += numBytes;
+    return true;
+  }
+
+
+  bool PLYWriter::reserve(size_t numBytes)
+  {
+    return (static_cast<size_t>(m_bufEnd - m_pos) >= numBytes) || flush();
+  }
+
+
+  bool PLYWriter::flush()
+  {
+    size_t numBytes = static_cast<size_t>(m_pos - m_buf);
+    if (numBytes > 0 && fwrite(m_buf, sizeof(char), numBytes, m_f) != numBytes) {
+      m_valid = false;
+    }
+    m_pos = m_buf;
+    return m_valid;
+  }
+
+
+  //
+  // Polygon triangulation
+  //
+
+  uint32_t triangulate_polygon(uint32_t n, const float pos[], uint32_t numVerts, const int indices[], int dst[])
+  {
+    PolygonScratch scratch;
+    return triangulate_polygon(n, pos, numVerts, indices, dst, scratch);
   }
 
 } // namespace miniply
@@ -44,6 +44,9 @@ namespace miniply {
 
   static constexpr uint32_t kInvalidIndex = 0xFFFFFFFFu;
 
+  // Default size of the buffer that a `PLYReader` reads the file into.
+  static constexpr uint32_t kPLYDefaultReadBufferSize = 128 * 1024;
+
   // Standard PLY element names
   extern const char* kPLYVertexElement; // "vertex"
   extern const char* kPLYFaceElement;   // "face"
@@ -60,6 +63,14 @@ namespace miniply {
   };
 
 
+  /// How a `PLYReader` gets data from the file.
+  enum class PLYReadMode {
+    Buffered,     //!< Read the file in chunks into a fixed-size buffer.
+    MemoryMapped, //!< Map the whole file into memory and parse it in place. Falls back to `Buffered` if the file can't be mapped.
+    Prefetch,     //!< Same as `Buffered`, but the next part of the file is read into a second buffer on a background thread while the current one is parsed.
+  };
+
+
   enum class PLYPropertyType {
     Char,
     UChar,
@@ -143,15 +154,45 @@ namespace miniply {
 
   class PLYReader {
   public:
-    PLYReader(const char* filename);
+    /// `bufferSize` is the size in bytes of the buffer used for reading the
+    /// file, which also limits the length of a single line of the header. It
+    /// isn't used if the file is memory mapped. In `Prefetch` mode there are
+    /// two buffers, each a little bigger than this.
+    PLYReader(const char* filename, PLYReadMode mode = PLYReadMode::Buffered, uint32_t bufferSize = kPLYDefaultReadBufferSize);
     ~PLYReader();
 
+    /// The mode actually used for reading the file. This can differ from the
+    /// mode passed to the constructor if memory mapping wasn't possible.
+    PLYReadMode read_mode() const;
+
     bool valid() const;
     bool has_element() const;
     const PLYElement* element() const;
+    /// Load the data for the current element. For an ASCII file, large
+    /// elements are parsed on multiple threads.
     bool load_element();
     void next_element();
 
+    /// Load the next block of up to `maxRows` rows of the current element,
+    /// replacing the previously loaded block. This lets a huge element be
+    /// streamed in fixed-size pieces without ever holding all of it in
+    /// memory: the same staging buffers are reused for every block, and any
+    /// registered destinations receive each block starting at their first
+    /// row, so they only need space for `maxRows` rows.
+    ///
+    /// After each call, `extract_properties()`, the list accessors and
+    /// `extract_triangles()` work on the rows of the current block, see
+    /// `first_loaded_row()` and `num_loaded_rows()`. Returns false once all
+    /// rows of the element have been loaded, or if there was an error, which
+    /// also makes `valid()` return false. `load_element()` can't be used
+    /// for an element that's being loaded this way.
+    bool load_element_rows(uint32_t maxRows);
+
+    /// Index of the first row loaded by the last call to `load_element()` or
+    /// `load_element_rows()`, and the number of rows that it loaded.
+    uint32_t first_loaded_row() const;
+    uint32_t num_loaded_rows() const;
+
     PLYFileType file_type() const;
     int version_major() const;
     int version_minor() const;
@@ -194,6 +235,34 @@ namespace miniply {
     /// `extract_list_column()` for those instead.
     bool extract_properties(const uint32_t propIdxs[], uint32_t numProps, PLYPropertyType destType, void* dest) const;
 
+    /// Register `dest` as the destination for the data of the specified
+    /// properties of the current element. This must be called before
+    /// `load_element()`. When the element is loaded, the property values are
+    /// decoded straight into `dest` and converted to `destType`, in the same
+    /// layout that `extract_properties()` would produce. No intermediate copy
+    /// of the element data is made. `dest` must have space for `numProps`
+    /// values per row.
+    ///
+    /// If any destinations are registered for an element, only properties
+    /// that have a destination are loaded, so `extract_properties()` and the
+    /// list accessors can't be used for that element. Destinations are cleared
+    /// by `next_element()`.
+    ///
+    /// Returns false if the element has already been loaded, or if any of the
+    /// property indexes is invalid or refers to a list property.
+    bool set_destination(const uint32_t propIdxs[], uint32_t numProps, PLYPropertyType destType, void* dest);
+
+    /// Register `dest` as the destination for the values of a list property
+    /// of the current element, where every list is expected to contain
+    /// exactly `listSize` items, e.g. the vertex indices of a triangle mesh.
+    /// `dest` must have space for `listSize` values per row. Loading the
+    /// element fails if any row has a list of a different size.
+    ///
+    /// See `set_destination()` for details. Returns false if the element has
+    /// already been loaded, if `listSize` is zero, or if the property index is
+    /// invalid or doesn't refer to a list property.
+    bool set_list_destination(uint32_t propIdx, uint32_t listSize, PLYPropertyType destType, void* dest);
+
     /// Get the array of item counts for a list property. Entry `i` in this
     /// array is the number of items in the `i`th list.
     const uint32_t* get_list_counts(uint32_t propIdx) const;
@@ -212,8 +281,28 @@ namespace miniply {
     bool find_indices(uint32_t propIdxs[1]) const;
 
   private:
+    /// A caller-provided buffer that properties of the current element are
+    /// loaded into directly, see `set_destination()`.
+    struct Destination {
+      std::vector<uint32_t> propIdxs;
+      PLYPropertyType type = PLYPropertyType::None;
+      uint8_t* data        = nullptr;
+      uint32_t listSize    = 0; //!< Number of items per row for a list property, zero for scalar properties.
+    };
+
+    /// A place that the values of a property are stored in when loading an
+    /// element: either a destination, or the staged element data.
+    struct Column {
+      uint8_t* data        = nullptr; //!< Position of the value for the first row. For a list property, the position of the first item.
+      size_t rowStride     = 0;       //!< Number of bytes between the values for consecutive rows.
+      PLYPropertyType type = PLYPropertyType::None;
+      uint32_t listSize    = 0;       //!< Expected list size, zero for scalar properties.
+    };
+
     bool refill_buffer();
     bool rewind_to_safe_char();
+    size_t read_file(char* dst, size_t numBytes);
+    void seek_file(int64_t offset);
     bool accept();
     bool advance();
     bool next_line();
@@ -236,21 +325,30 @@ namespace miniply {
     bool parse_element();
     bool parse_property(std::vector<PLYProperty>& properties);
 
-    bool load_fixed_size_element(PLYElement& elem);
-    bool load_variable_size_element(PLYElement& elem);
+    bool load_rows(PLYElement& elem, uint32_t numRows);
+    bool load_fixed_size_element(PLYElement& elem, uint32_t numRows);
+    bool load_variable_size_element(PLYElement& elem, uint32_t numRows);
+    bool load_fixed_size_element_to_destinations(PLYElement& elem, uint32_t numRows);
+    bool load_element_rows_to_destinations(PLYElement& elem, uint32_t numRows);
+    bool load_ascii_element(PLYElement& elem, uint32_t numRows);
+    void destination_columns(const PLYElement& elem, std::vector<std::vector<Column>>& columns) const;
+
+    static const char* parse_ascii_rows(const PLYElement& elem, const std::vector<std::vector<Column>>& columns,
+                                        std::vector<PLYProperty>* lists, const char* pos, const char* end,
+                                        uint32_t firstRow, uint32_t maxRows, uint32_t* numRows);
 
-    bool load_ascii_scalar_property(PLYProperty& prop, size_t& destIndex);
-    bool load_ascii_list_property(PLYProperty& prop);
     bool load_binary_scalar_property(PLYProperty& prop, size_t& destIndex);
     bool load_binary_list_property(PLYProperty& prop);
-    bool load_binary_scalar_property_big_endian(PLYProperty& prop, size_t& destIndex);
-    bool load_binary_list_property_big_endian(PLYProperty& prop);
 
-    bool ascii_value(PLYPropertyType propType, uint8_t value[8]);
+    bool binary_value(PLYPropertyType propType, uint8_t value[8]);
 
   private:
+    struct Prefetcher;
+
     FILE* m_f             = nullptr;
-    char* m_buf           = nullptr;
+    Prefetcher* m_prefetcher = nullptr; //!< Background reader for the file, only used in `Prefetch` mode.
+    uint32_t m_bufSize    = kPLYDefaultReadBufferSize;
+    char* m_buf           = nullptr; //!< Read buffer, or the start of the file contents if the file is memory mapped.
     const char* m_bufEnd  = nullptr;
     const char* m_pos     = nullptr;
     const char* m_end     = nullptr;
@@ -259,6 +357,7 @@ namespace miniply {
     int64_t m_bufOffset   = 0;
 
     bool m_valid          = false;
+    PLYReadMode m_readMode = PLYReadMode::Buffered;
 
     PLYFileType m_fileType = PLYFileType::ASCII; //!< Whether the file was ascii, binary little-endian, or binary big-endian.
     int m_majorVersion     = 0;
@@ -266,13 +365,146 @@ namespace miniply {
     std::vector<PLYElement> m_elements;         //!< Element descriptors for this file.
 
     size_t m_currentElement = 0;
-    bool m_elementLoaded    = false;
+    bool m_elementLoaded    = false; //!< Whether any rows of the current element have been loaded.
+    uint32_t m_nextRow      = 0;     //!< Index of the first row of the current element that hasn't been loaded yet.
+    uint32_t m_firstLoadedRow = 0;
+    uint32_t m_numLoadedRows  = 0;   //!< Number of rows in `m_elementRows` and the list data of the current element.
     std::vector<uint8_t> m_elementData;
+    const uint8_t* m_elementRows = nullptr; //!< Fixed-size row data for the loaded element. Points into `m_elementData`, or directly into the file contents if the file is memory mapped.
+    std::vector<Destination> m_destinations; //!< Destinations registered for the current element.
 
     char* m_tmpBuf = nullptr;
   };
 
 
+  /// Writes PLY files, using the same element and property model as
+  /// `PLYReader`. Describe the elements of the file with `add_element()`,
+  /// `add_property()` and `add_list_property()`, tell the writer where the
+  /// data for each property comes from with `set_source()` and friends, then
+  /// call `write()` to write the whole file in one go.
+  ///
+  /// The data is read straight from the source arrays while writing, without
+  /// making a copy first, so they must stay valid until `write()` returns.
+  class PLYWriter {
+  public:
+    PLYWriter(const char* filename, PLYFileType fileType = PLYFileType::Binary);
+    ~PLYWriter();
+
+    bool valid() const;
+    PLYFileType file_type() const;
+
+    /// Add a comment line to the header.
+    bool add_comment(const char* comment);
+
+    /// Add an element with `count` rows to the file. Elements are written in
+    /// the order they're added. Returns the index of the new element, or
+    /// `kInvalidIndex` if the file has already been written.
+    uint32_t add_element(const char* name, uint32_t count);
+
+    /// Add a property to the element with index `elemIdx`. Returns the index
+    /// of the new property within the element, or `kInvalidIndex` if the
+    /// element index is invalid.
+    uint32_t add_property(uint32_t elemIdx, const char* name, PLYPropertyType type);
+
+    /// Same as `add_property()`, for a list property whose item counts are
+    /// stored as `countType` and whose items are stored as `type`.
+    uint32_t add_list_property(uint32_t elemIdx, const char* name, PLYPropertyType countType, PLYPropertyType type);
+
+    uint32_t num_elements() const;
+    const PLYElement* get_element(uint32_t idx) const;
+
+    /// The mirror image of `PLYReader::extract_properties()`: the values of
+    /// the specified properties of an element are taken from `src`, which
+    /// holds `numProps` values of type `srcType` per row. They are converted
+    /// to the property types as they're written. `srcStride` is the number of
+    /// bytes from the start of one row in `src` to the next; if it's zero, the
+    /// rows are assumed to be tightly packed.
+    ///
+    /// Returns false if any of the indexes is invalid or refers to a list
+    /// property.
+    bool set_source(uint32_t elemIdx, const uint32_t propIdxs[], uint32_t numProps, PLYPropertyType srcType, const void* src, size_t srcStride = 0);
+
+    /// Take the values of a list property from `src`, where every list has
+    /// exactly `listSize` items, e.g. the vertex indices of a triangle mesh.
+    /// `srcStride` works the same way as for `set_source()`.
+    bool set_list_source(uint32_t elemIdx, uint32_t propIdx, uint32_t listSize, PLYPropertyType srcType, const void* src, size_t srcStride = 0);
+
+    /// Take the values of a list property from `src`, where entry `i` of
+    /// `counts` is the number of items in the `i`th list and the items for
+    /// all rows are stored back to back, as `PLYReader::get_list_counts()`
+    /// and `PLYReader::extract_list_property()` provide them.
+    bool set_variable_list_source(uint32_t elemIdx, uint32_t propIdx, const uint32_t counts[], PLYPropertyType srcType, const void* src);
+
+    /// Write the header and the data for all elements. Every property of an
+    /// element with at least one row must have a source. This can only be
+    /// called once. Returns false if anything went wrong.
+    bool write();
+
+  private:
+    /// Where the values of a property are written from.
+    struct Source {
+      const uint8_t* data    = nullptr; //!< Position of the value for the first row. For a list property, the position of the first item.
+      size_t rowStride       = 0;       //!< Number of bytes between the values for consecutive rows, for a fixed-size list or scalar property.
+      PLYPropertyType type   = PLYPropertyType::None;
+      uint32_t listSize      = 0;       //!< Number of items per row for a fixed-size list property.
+      const uint32_t* counts = nullptr; //!< Number of items for each row, for a variable-size list property.
+    };
+
+    bool write_header();
+    bool write_fixed_size_element(const PLYElement& elem, const std::vector<Source>& sources);
+    bool write_element_rows(const PLYElement& elem, const std::vector<Source>& sources);
+    bool write_value(PLYPropertyType type, const uint8_t* src, PLYPropertyType srcType);
+    bool write_bytes(const void* data, size_t numBytes);
+    bool reserve(size_t numBytes);
+    bool flush();
+
+  private:
+    FILE* m_f             = nullptr;
+    char* m_buf           = nullptr; //!< Write buffer.
+    const char* m_bufEnd  = nullptr;
+    char* m_pos           = nullptr; //!< Where the next byte goes in the write buffer.
+
+    bool m_valid          = false;
+    bool m_written        = false;
+
+    PLYFileType m_fileType = PLYFileType::Binary;
+    std::vector<std::string> m_comments;
+    std::vector<PLYElement> m_elements;
+    std::vector<std::vector<Source>> m_sources; //!< Entry `i` holds the source for every property of element `i`.
+  };
+
+
+  /// Used in a `PLYHeader` for a size or offset which can't be worked out from
+  /// the header alone.
+  static constexpr uint64_t kPLYUnknownSize = 0xFFFFFFFFFFFFFFFFull;
+
+
+  /// Layout of a PLY file, as described by its header. See `probe_ply()`.
+  struct PLYHeader {
+    PLYFileType             fileType     = PLYFileType::ASCII;
+    int                     majorVersion = 0;
+    int                     minorVersion = 0;
+    uint64_t                dataOffset   = 0; //!< Byte offset from the start of the file to the first byte after the header.
+    std::vector<PLYElement> elements;         //!< Elements and their properties, with offsets and strides calculated. They never hold any data.
+    std::vector<uint64_t>   elementSizes;     //!< Entry `i` is the size in bytes of the data for element `i`, or `kPLYUnknownSize`.
+    std::vector<uint64_t>   elementOffsets;   //!< Entry `i` is the byte offset in the file where the data for element `i` starts, or `kPLYUnknownSize`.
+  };
+
+
+  /// Reads only the header of a PLY file, without the buffers and other setup
+  /// that a `PLYReader` needs, so it's cheap enough to call on a large number
+  /// of files. The file is read in small pieces until the end of the header
+  /// turns up, which is a single read for most files.
+  ///
+  /// The size of an element is known if the file is binary and the element
+  /// has no list properties, or no rows. The offset of an element is known if
+  /// the sizes of all elements before it are known.
+  ///
+  /// `header` can be reused from one call to the next. Returns false if the
+  /// file can't be opened or doesn't start with a valid PLY header.
+  bool probe_ply(const char* filename, PLYHeader* header);
+
+
   /// Given a polygon with `n` vertices, where `n` > 3, triangulate it and
   /// store the indices for the resulting triangles in `dst`. The `pos`
   /// parameter is the array of all vertex positions for the mesh; `indices` is
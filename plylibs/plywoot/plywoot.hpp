@@ -27,7 +27,13 @@
 #include "plywoot/binary_parser_policy.hpp"
 #include "plywoot/binary_writer_policy.hpp"
 #include "plywoot/element_data.hpp"
+#include "plywoot/element_reader.hpp"
+#include "plywoot/element_writer.hpp"
+#include "plywoot/file_ostream.hpp"
 #include "plywoot/header_parser.hpp"
+#include "plywoot/header_writer.hpp"
+#include "plywoot/index.hpp"
+#include "plywoot/parallel.hpp"
 #include "plywoot/parser.hpp"
 #include "plywoot/parser_variant.hpp"
 #include "plywoot/reflect.hpp"
@@ -37,15 +43,35 @@
 #include "plywoot/writer_variant.hpp"
 
 #include <algorithm>
+#include <array>
 #include <cstdint>
+#include <fstream>
 #include <functional>
 #include <istream>
 #include <optional>
 #include <ostream>
+#include <sstream>
 #include <string>
 #include <utility>
 #include <vector>
 
+namespace {
+
+/// Maximum number of rows of element data that is kept in memory at once when
+/// converting PLY data from one format to another; may need tweaking.
+constexpr std::size_t ConvertRowsPerChunk{64 * 1024};
+
+/// Default number of rows between two consecutive checkpoints in a PLY index,
+/// for elements that do not have a fixed row size; may need tweaking.
+constexpr std::size_t IndexRowsPerCheckpoint{64 * 1024};
+
+/// Minimum number of rows of element data written by a single thread when
+/// writing binary PLY data with fixed size rows to a file in parallel; may
+/// need tweaking.
+constexpr std::size_t MinRowsPerWriteThread{64 * 1024};
+
+}
+
 namespace plywoot {
 
 /// Represents an input PLY data stream that can be queried for data.
@@ -104,10 +130,18 @@ public:
   }
 
   /// Returns a copy of the current element that can be either read or skipped.
-  /// In case no element can be read, returns a default constructed element.
+  /// In case no element can be read, returns a default constructed element. In
+  /// case the read head is positioned in the middle of the current element,
+  /// see `seek()`, the size of the returned element equals the number of rows
+  /// remaining in the current element.
   ///
   /// \return  a copy of the current element that can be either read or skipped
-  PlyElement element() const { return hasElement() ? *currElement_ : PlyElement{}; }
+  PlyElement element() const
+  {
+    if (!hasElement()) return PlyElement{};
+    if (currRow_ == 0) return *currElement_;
+    return PlyElement{currElement_->name(), currElement_->size() - currRow_, currElement_->properties()};
+  }
   /// Returns whether there are still elements left to parse.
   ///
   /// \return \c true in case there are still elements left to parse, \c false
@@ -117,13 +151,35 @@ public:
   /// Reads an element to a newly allocated block of memory wrapped by a
   /// `PlyElementData` instance. PLY data types are directly mapped to their
   /// corresponding native types. Lists are mapped to an `std::vector<T>` where
-  /// `T` is the type of type of the element in the lists. All data is aligned
+  /// `T` is the type of type of the element in the lists, or to a
+  /// `PlyListRef` into a single list arena, depending on \p listStorage. All data is aligned
   /// according to the alignment requirements of the compiler platform.
   ///
+  /// \param listStorage defines how variable length lists are stored; arena
+  ///     storage avoids allocating a separate `std::vector` for every list
   /// \pre `hasElement()` must be \c true
   /// \return memory block in the form of a `PlyElementData` instance
   ///     representing all data for the active element to be parsed
-  PlyElementData readElement() const { return parser_.read(*currElement_++); }
+  PlyElementData readElement(PlyListStorage listStorage = PlyListStorage::Vector) const
+  {
+    return parser_.read(takeRows(currElement_->size()), listStorage);
+  }
+
+  /// Reads at most \p n rows of the current element to a newly allocated block
+  /// of memory wrapped by a `PlyElementData` instance, see `readElement()`. In
+  /// case no rows remain in the current element after reading, the read head
+  /// moves on to the next element. Together with `seek()`, this allows reading
+  /// arbitrary ranges of rows.
+  ///
+  /// \param n maximum number of rows to read
+  /// \param listStorage defines how variable length lists are stored
+  /// \pre `hasElement()` must be \c true
+  /// \return memory block in the form of a `PlyElementData` instance
+  ///     representing the rows that were read
+  PlyElementData readRows(std::size_t n, PlyListStorage listStorage = PlyListStorage::Vector) const
+  {
+    return parser_.read(takeRows(n), listStorage);
+  }
 
   /// Reads the current element from the PLY input data stream into memory
   /// pointed to by \p dest, where the `Layout` type is used to identify how
@@ -144,7 +200,7 @@ public:
   template<typename T, typename Layout>
   void readElement(T *dest) const
   {
-    parser_.read<Layout>(*currElement_++, reinterpret_cast<std::uint8_t *>(dest), alignof(T));
+    parser_.read<Layout>(takeRows(currElement_->size()), reinterpret_cast<std::uint8_t *>(dest), alignof(T));
   }
 
   /// Reads the current element from the PLY input data stream, returning a list
@@ -161,13 +217,236 @@ public:
   template<typename T, typename Layout>
   std::vector<T> readElement() const
   {
-    std::vector<T> result(currElement_->size());
-    parser_.read<Layout>(*currElement_++, reinterpret_cast<std::uint8_t *>(result.data()), alignof(T));
+    return readRows<T, Layout>(currElement_->size());
+  }
+
+  /// Reads at most \p n rows of the current element from the PLY input data
+  /// stream, returning a list of objects of type `T`, where the `Layout` type
+  /// is used to identify how properties from the PLY element are mapped on
+  /// objects of type `T`. In case no rows remain in the current element after
+  /// reading, the read head moves on to the next element.
+  ///
+  /// \param n maximum number of rows to read
+  /// \tparam T type of objects to be read from the stream
+  /// \tparam Layout layout specifying the mapping of PLY properties to `T`
+  /// \pre `hasElement()` must be \c true
+  /// \return a vector of objects of type `T` representing the rows that were
+  ///     read
+  template<typename T, typename Layout>
+  std::vector<T> readRows(std::size_t n) const
+  {
+    const PlyElement rows = takeRows(n);
+    std::vector<T> result(rows.size());
+    parser_.read<Layout>(rows, reinterpret_cast<std::uint8_t *>(result.data()), alignof(T));
     return result;
   }
 
+  /// Reads the current element from the PLY input data stream in chunks of at
+  /// most \p rowsPerChunk objects of type `T`, where the `Layout` type is used
+  /// to identify how properties from the PLY element are mapped on objects of
+  /// type `T`. After reading each chunk, \p callback is invoked as
+  /// `callback(const T *chunk, std::size_t n)`, where `n` is the number of
+  /// objects in the chunk. A single chunk buffer is reused for all chunks, so
+  /// the chunk data is only valid for the duration of the callback.
+  ///
+  /// \param rowsPerChunk maximum number of objects of type `T` per chunk
+  /// \param callback function to invoke for each chunk
+  /// \tparam T type of objects to be read from the stream
+  /// \tparam Layout layout specifying the mapping of PLY properties to `T`
+  /// \pre `hasElement()` must be \c true
+  template<typename T, typename Layout, typename Callback>
+  void readElementChunks(std::size_t rowsPerChunk, Callback callback) const
+  {
+    const PlyElement element = takeRows(currElement_->size());
+    rowsPerChunk = std::max<std::size_t>(1, rowsPerChunk);
+
+    std::vector<T> chunk(std::min(rowsPerChunk, element.size()));
+    for (std::size_t row = 0; row < element.size(); row += rowsPerChunk)
+    {
+      const std::size_t n = std::min(rowsPerChunk, element.size() - row);
+      parser_.read<Layout>(
+          PlyElement{element.name(), n, element.properties()}, reinterpret_cast<std::uint8_t *>(chunk.data()),
+          alignof(T));
+      callback(static_cast<const T *>(chunk.data()), n);
+    }
+  }
+
+  /// Reads the current element from the PLY input data stream in chunks of at
+  /// most \p rowsPerChunk rows, where each chunk is represented by a
+  /// `PlyElementData` instance, see `readElement()`. After reading each chunk,
+  /// \p callback is invoked as `callback(const PlyElementData &chunk)`. The
+  /// element associated with each chunk has the same name and properties as
+  /// the current element, but its size equals the number of rows in the chunk.
+  ///
+  /// \param rowsPerChunk maximum number of rows per chunk
+  /// \param callback function to invoke for each chunk
+  /// \param listStorage defines how variable length lists are stored
+  /// \pre `hasElement()` must be \c true
+  template<typename Callback>
+  void readElementChunks(
+      std::size_t rowsPerChunk,
+      Callback callback,
+      PlyListStorage listStorage = PlyListStorage::Vector) const
+  {
+    const PlyElement element = takeRows(currElement_->size());
+    rowsPerChunk = std::max<std::size_t>(1, rowsPerChunk);
+
+    for (std::size_t row = 0; row < element.size(); row += rowsPerChunk)
+    {
+      const std::size_t n = std::min(rowsPerChunk, element.size() - row);
+      const PlyElementData chunk =
+          parser_.read(PlyElement{element.name(), n, element.properties()}, listStorage);
+      callback(chunk);
+    }
+  }
+
   /// Skips the current element.
-  void skipElement() const { parser_.skip(*currElement_++); }
+  void skipElement() const { parser_.skip(takeRows(currElement_->size())); }
+
+  /// Builds an index of the element data, which records the offset of every
+  /// element, and for elements that do not have a fixed row size, the offset of
+  /// every \p rowsPerCheckpoint-th row. This requires parsing all element data
+  /// once, but not converting it; the position of the read head is restored
+  /// afterwards. The index can be saved, to be used later on through
+  /// `setIndex()`, which allows skipping this step.
+  ///
+  /// \param rowsPerCheckpoint number of rows between two consecutive
+  ///     checkpoints for elements that do not have a fixed row size
+  /// \return an index of the element data
+  PlyIndex buildIndex(std::size_t rowsPerCheckpoint = IndexRowsPerCheckpoint) const
+  {
+    rowsPerCheckpoint = std::max<std::size_t>(1, rowsPerCheckpoint);
+
+    const std::uint64_t position = parser_.position();
+    parser_.seek(0);
+
+    std::vector<PlyIndex::Entry> entries;
+    entries.reserve(elements_.size());
+    for (const PlyElement &element : elements_)
+    {
+      PlyIndex::Entry entry;
+      entry.name = element.name();
+      entry.size = element.size();
+      entry.offset = parser_.position();
+
+      const PlyPropertyConstIterator first = element.properties().begin();
+      const PlyPropertyConstIterator last = element.properties().end();
+      const std::optional<std::size_t> rowSize =
+          format_ == PlyFormat::Ascii ? std::nullopt : detail::fixedRowSize<>(first, last);
+
+      if (rowSize && *rowSize > 0)
+      {
+        entry.rowSize = *rowSize;
+        parser_.skip(element);
+      }
+      else
+      {
+        entry.rowsPerCheckpoint = rowsPerCheckpoint;
+        for (std::size_t row = 0; row < element.size(); row += rowsPerCheckpoint)
+        {
+          const std::size_t n = std::min(rowsPerCheckpoint, element.size() - row);
+          entry.checkpoints.push_back(parser_.position());
+          parser_.skip(PlyElement{element.name(), n, element.properties()});
+        }
+      }
+
+      entries.push_back(std::move(entry));
+    }
+
+    parser_.seek(position);
+
+    return PlyIndex{std::move(entries)};
+  }
+
+  /// Returns an index of the element data that is computed from the header
+  /// alone, in case the offsets of all elements follow from it. This is the
+  /// case for binary data in which all elements, except possibly the last
+  /// one, have a fixed row size.
+  ///
+  /// \return an index of the element data in case it follows from the header,
+  ///     `std::nullopt` otherwise
+  std::optional<PlyIndex> headerIndex() const
+  {
+    if (format_ == PlyFormat::Ascii) return std::nullopt;
+
+    std::vector<PlyIndex::Entry> entries;
+    entries.reserve(elements_.size());
+
+    std::uint64_t offset{0};
+    bool variableRowSize{false};
+    for (const PlyElement &element : elements_)
+    {
+      // Note; the offset of an element following one with variable length
+      // rows does not follow from the header.
+      if (variableRowSize) return std::nullopt;
+
+      PlyIndex::Entry entry;
+      entry.name = element.name();
+      entry.size = element.size();
+      entry.offset = offset;
+
+      const std::optional<std::size_t> rowSize =
+          detail::fixedRowSize<>(element.properties().begin(), element.properties().end());
+      if (rowSize)
+      {
+        entry.rowSize = *rowSize;
+        offset += static_cast<std::uint64_t>(element.size()) * *rowSize;
+      }
+      else
+      {
+        // Note; only the offset of the first row of an element with variable
+        // length rows is known, which acts as its only checkpoint.
+        entry.rowsPerCheckpoint = std::max<std::size_t>(1, element.size());
+        entry.checkpoints.push_back(offset);
+        variableRowSize = true;
+      }
+
+      entries.push_back(std::move(entry));
+    }
+
+    return PlyIndex{std::move(entries)};
+  }
+
+  /// Associates the given index with this input stream, to be used by
+  /// `seek()`, for example an index that was built earlier using
+  /// `buildIndex()` and saved.
+  ///
+  /// \param index index of the element data of this input stream
+  /// \throws InvalidPlyIndex in case the index does not match the elements of
+  ///     this input stream
+  void setIndex(PlyIndex index)
+  {
+    if (!index.matches(elements_)) { throw InvalidPlyIndex{"index does not match the PLY header"}; }
+    index_ = std::move(index);
+  }
+
+  /// Positions the read head at the given row of the element with the given
+  /// name, after which that element is the current element, see `element()`.
+  /// Uses the index associated with this stream, see `setIndex()`; in case no
+  /// index is associated with this stream yet, one is built first, see
+  /// `buildIndex()`. Requires the wrapped input stream to be seekable.
+  ///
+  /// \param elementName name of the element to position the read head in
+  /// \param row row in the element to position the read head at
+  /// \return \c true in case the element exists, and the row is in range,
+  ///     \c false otherwise
+  bool seek(const std::string &elementName, std::size_t row) const
+  {
+    const auto it = std::find_if(
+        elements_.begin(), elements_.end(), [&](const PlyElement &e) { return e.name() == elementName; });
+    if (it == elements_.end() || row > it->size()) return false;
+
+    if (!index_) { index_ = buildIndex(); }
+
+    const auto [checkpointRow, offset] = index_->checkpoint(it - elements_.begin(), row);
+    parser_.seek(offset);
+
+    currElement_ = it;
+    currRow_ = checkpointRow;
+    parser_.skip(takeRows(row - checkpointRow));
+
+    return true;
+  }
 
 private:
   /// Constructs a PLY file from the given input stream and header parser.
@@ -194,8 +473,36 @@ private:
   /// Format of the PLY input data, either ASCII, little-, or big-endian binary.
   PlyFormat format_;
 
+  /// Returns at most \p n rows of the current element starting at the current
+  /// row as an element definition, and advances the current row past those
+  /// rows. Moves on to the next element in case no rows remain in the current
+  /// element.
+  ///
+  /// \param n maximum number of rows to take
+  /// \return an element definition of which the size equals the number of
+  ///     rows taken
+  PlyElement takeRows(std::size_t n) const
+  {
+    const PlyElement &element = *currElement_;
+    n = std::min(n, element.size() - currRow_);
+
+    PlyElement result{element.name(), n, element.properties()};
+    currRow_ += n;
+    if (currRow_ == element.size())
+    {
+      ++currElement_;
+      currRow_ = 0;
+    }
+
+    return result;
+  }
+
   /// Iterator pointing to the current element.
   mutable std::vector<PlyElement>::const_iterator currElement_;
+  /// Row in the current element the read head is positioned at.
+  mutable std::size_t currRow_{0};
+  /// Index of the element data, used by `seek()`.
+  mutable std::optional<PlyIndex> index_;
 };
 
 /// Represents an output PLY data stream that can be used to output data to a
@@ -237,9 +544,16 @@ public:
     // items in the input layout.
     PlyElement layoutElement{element.name(), layout.size(), element.properties()};
 
-    elementWriteClosures_.emplace_back(
-        std::move(layoutElement),
-        [layout](detail::WriterVariant &writer, const PlyElement &e) { writer.write(e, layout); });
+    const PlyPropertyConstIterator first = element.properties().begin();
+    const PlyPropertyConstIterator last = element.properties().end();
+    std::optional<std::size_t> rowSize = detail::fixedRowSize<Ts...>(first, last);
+
+    elementWriteClosures_.push_back(
+        {std::move(layoutElement),
+         [layout](detail::WriterVariant &writer, const PlyElement &e, std::size_t first, std::size_t last) {
+           writer.write(e, layout.slice(first, last));
+         },
+         rowSize});
   }
 
   /// Queues the given element data for writing. This takes ownership of the
@@ -251,14 +565,28 @@ public:
   {
     // TODO(ton): ideally, move capture element data in the lambda below, but it
     // runs into the issue that the `std::function` instance needs to be
-    // copyable.
+    // copyable. Use `plywoot::write()` to hand off element data instead.
     const std::uint8_t *src = elementData.data();
     const std::size_t alignment = elementData.alignment();
-
-    elementWriteClosures_.emplace_back(
-        elementData.element(), [src, alignment](detail::WriterVariant &writer, const PlyElement &e) {
-          writer.write(e, src, alignment);
-        });
+    const std::size_t bytesPerElement = elementData.bytesPerElement();
+    const std::uint8_t *listArena = elementData.listArena();
+
+    const PlyElement &element = elementData.element();
+    std::optional<std::size_t> rowSize =
+        detail::fixedRowSize<>(element.properties().begin(), element.properties().end());
+
+    elementWriteClosures_.push_back(
+        {element,
+         [src, alignment, bytesPerElement, listArena](
+             detail::WriterVariant &writer, const PlyElement &e, std::size_t first, std::size_t last) {
+           if (first == 0 && last == e.size()) { writer.write(e, src, alignment, listArena); }
+           else
+           {
+             const PlyElement range{e.name(), last - first, e.properties()};
+             writer.write(range, src + first * bytesPerElement, alignment, listArena);
+           }
+         },
+         rowSize});
   }
 
   /// Writes all data as a PLY file queued through `addElement()` to the given
@@ -270,12 +598,58 @@ public:
     writeHeader(os);
 
     detail::WriterVariant writer{os, format_};
-    for (const auto &elementClosurePair : elementWriteClosures_)
+    for (const QueuedElement &queued : elementWriteClosures_)
     {
-      const PlyElement &element{elementClosurePair.first};
-      const auto &writeFn = elementClosurePair.second;
-      writeFn(writer, element);
+      queued.write(writer, queued.element, 0, queued.element.size());
     }
+
+    // Note; flush explicitly, so that write errors are reported here rather
+    // than being suppressed when the writer goes out of scope.
+    writer.flush();
+  }
+
+  /// Writes all data as a PLY file queued through `addElement()` to the file
+  /// at the given path, truncating it in case it exists already. Where
+  /// supported, the file is written through a raw file descriptor: formatted
+  /// data is staged in large aligned buffers, while large blocks of binary
+  /// data are handed to the operating system directly from the source buffers.
+  /// In case the size of the output file follows from the header (binary
+  /// output without variable length lists), disk space for the complete file
+  /// is reserved up front if `options.preallocate` is set. Moreover, the
+  /// offset of every row in the output file is known in that case, so rows are
+  /// written by multiple threads concurrently, unless direct I/O is requested.
+  ///
+  /// \param path path of the file to write the queued element data to
+  /// \param options options controlling the way the file is written
+  /// \throws IoError in case the file could not be written
+  void write(const char *path, FileWriteOptions options = {}) const
+  {
+#ifdef PLYWOOT_HAS_POSIX_FILE_IO
+    const std::optional<std::uint64_t> size = fileSize();
+    if (size && !options.direct && detail::maxThreads() > 1)
+    {
+      writeParallel(path, *size, options);
+      return;
+    }
+
+    detail::FileOStreamBuf buf{path, options.direct};
+    if (size && options.preallocate) { buf.preallocate(*size); }
+
+    // Note; rethrow I/O errors reported by the stream buffer, rather than just
+    // setting the bad bit on the output stream.
+    std::ostream os{&buf};
+    os.exceptions(std::ios::badbit);
+    write(os);
+    buf.close();
+#else
+    (void)options;
+
+    std::ofstream os{path, std::ios::binary};
+    if (!os) { throw IoError{std::string{"unable to open '"} + path + "'"}; }
+    write(os);
+    os.close();
+    if (!os) { throw IoError{"unable to write to file"}; }
+#endif
   }
 
 private:
@@ -285,63 +659,102 @@ private:
   /// \param os output stream to write the PLY header data to
   void writeHeader(std::ostream &os) const
   {
-    os << "ply\n";
+    std::vector<PlyElement> elements;
+    elements.reserve(elementWriteClosures_.size());
+    for (const QueuedElement &queued : elementWriteClosures_) { elements.push_back(queued.element); }
 
-    switch (format_)
+    detail::writeHeader(os, format_, comments_, elements);
+  }
+
+  /// Returns the size in bytes of the PLY file that is written by `write()`,
+  /// in case it can be determined up front. This is only the case for binary
+  /// output for which all queued elements have a fixed row size.
+  ///
+  /// \return the size in bytes of the output PLY file, if known
+  std::optional<std::uint64_t> fileSize() const
+  {
+    if (format_ == PlyFormat::Ascii) return std::nullopt;
+
+    std::ostringstream header;
+    writeHeader(header);
+
+    std::uint64_t result = header.str().size();
+    for (const QueuedElement &queued : elementWriteClosures_)
     {
-      case PlyFormat::Ascii:
-        os << "format ascii 1.0\n";
-        break;
-      case PlyFormat::BinaryBigEndian:
-        os << "format binary_big_endian 1.0\n";
-        break;
-      case PlyFormat::BinaryLittleEndian:
-        os << "format binary_little_endian 1.0\n";
-        break;
+      if (!queued.rowSize) return std::nullopt;
+      result += *queued.rowSize * queued.element.size();
     }
 
-    // Maintain line number to be able to serialize comments at the right
-    // location in the header. Comments may only occur after the 'ply' magic
-    // 'number', and the format specification. Ideally this state should be
-    // limited to the scope of the closure, but that is not supported in C++11.
-    std::uint32_t line = 2;
-    auto first = comments_.begin();
-    const auto last = comments_.end();
-    const auto maybeWriteComments = [&]() {
-      while (first != last && first->line == line++)
-      {
-        if (first->text.empty()) { os << "comment\n"; }
-        else { os << "comment " << first->text << '\n'; }
-        ++first;
-      }
-    };
+    return result;
+  }
 
-    for (const auto &elementClosurePair : elementWriteClosures_)
-    {
-      maybeWriteComments();
-      const PlyElement &element{elementClosurePair.first};
-      os << "element " << element.name() << ' ' << element.size() << '\n';
+#ifdef PLYWOOT_HAS_POSIX_FILE_IO
+  /// Writes all queued data as a binary PLY file of the given size to the file
+  /// at the given path, which requires all queued elements to have a fixed row
+  /// size. Since the offset of every row is known up front, the file is
+  /// created with its final size, and disjoint ranges of rows of every element
+  /// are written concurrently using positioned writes. The header is written
+  /// last.
+  ///
+  /// \param path path of the file to write the queued element data to
+  /// \param size size in bytes of the PLY file, see `fileSize()`
+  /// \param options options controlling the way the file is written
+  void writeParallel(const char *path, std::uint64_t size, FileWriteOptions options) const
+  {
+    detail::PresizedFile file{path, size};
+    // Note; resizing the file only makes it sparse, so reserve the actual disk
+    // space separately.
+    if (options.preallocate) { detail::preallocateFile(file.fd(), size); }
 
-      for (const PlyProperty &property : element.properties())
-      {
-        maybeWriteComments();
-        if (property.isList())
-        {
-          os << "property list " << property.sizeType() << ' ' << property.type() << ' ' << property.name()
-             << '\n';
-        }
-        else { os << "property " << property.type() << ' ' << property.name() << '\n'; }
-      }
+    std::ostringstream header;
+    writeHeader(header);
+
+    std::uint64_t offset = header.str().size();
+    for (const QueuedElement &queued : elementWriteClosures_)
+    {
+      const std::size_t numRows = queued.element.size();
+      const std::size_t rowSize = *queued.rowSize;
+      const std::size_t numThreads = std::min(detail::maxThreads(), numRows / MinRowsPerWriteThread);
+
+      detail::parallelFor(numRows, numThreads, [&](std::size_t first, std::size_t last) {
+        detail::PositionedOStreamBuf buf{file.fd(), offset + first * rowSize};
+        std::ostream os{&buf};
+        os.exceptions(std::ios::badbit);
+        detail::WriterVariant writer{os, format_};
+        queued.write(writer, queued.element, first, last);
+        writer.flush();
+        buf.close();
+      });
+
+      offset += static_cast<std::uint64_t>(numRows) * rowSize;
     }
 
-    maybeWriteComments();
-    os << "end_header\n";
+    const std::string headerData = header.str();
+    detail::PositionedOStreamBuf buf{file.fd(), 0};
+    buf.sputn(headerData.data(), static_cast<std::streamsize>(headerData.size()));
+    buf.close();
+
+    file.close();
   }
+#endif
 
-  using ElementWriteClosure = std::function<void(detail::WriterVariant &, const PlyElement &)>;
+  using ElementWriteClosure =
+      std::function<void(detail::WriterVariant &, const PlyElement &, std::size_t first, std::size_t last)>;
+
+  /// Element queued for writing.
+  struct QueuedElement
+  {
+    /// Element definition, of which the size equals the number of rows to
+    /// write.
+    PlyElement element;
+    /// Writes the rows [`first`, `last`) of the element data to a writer.
+    ElementWriteClosure write;
+    /// Size in bytes of a single row in binary format, in case it is fixed.
+    std::optional<std::size_t> rowSize;
+  };
 
   /// All queued elements with the associated data.
-  std::vector<std::pair<PlyElement, ElementWriteClosure>> elementWriteClosures_;
+  std::vector<QueuedElement> elementWriteClosures_;
   /// Format the PLY data should be written in.
   PlyFormat format_;
   /// Comments to write out to the PLY file. Invariant is that comments are
@@ -349,8 +762,155 @@ private:
   std::vector<Comment> comments_;
 };
 
+/// Creates an element to be read through `plywoot::readElements()` into a list
+/// of objects of type `T`, where the `Layout` type is used to identify how
+/// properties from the PLY element are mapped on objects of type `T`.
+///
+/// \param name name of the element to read
+/// \param dest list of objects to store the element data in
+/// \tparam T type of objects to be read from the stream
+/// \tparam Layout layout specifying the mapping of PLY properties to `T`
+/// \return an element to be read through `plywoot::readElements()`
+template<typename T, typename Layout>
+detail::LayoutElementReader<T, Layout> into(std::string name, std::vector<T> &dest)
+{
+  return {std::move(name), dest};
+}
+
+/// Creates an element to be read through `plywoot::readElements()` into a
+/// `PlyElementData` instance, see `IStream::readElement()`.
+///
+/// \param name name of the element to read
+/// \param dest element data instance to store the element data in
+/// \param listStorage defines how variable length lists are stored
+/// \return an element to be read through `plywoot::readElements()`
+inline detail::DataElementReader
+into(std::string name, PlyElementData &dest, PlyListStorage listStorage = PlyListStorage::Vector)
+{
+  return {std::move(name), dest, listStorage};
+}
+
+/// Reads the given elements from the PLY file at the given path. In case the
+/// offset of every element follows from the header, see
+/// `IStream::headerIndex()`, the elements are read concurrently, each from its
+/// own input stream that skips directly to the start of the element. Otherwise, the
+/// elements are read one after the other. Elements that do not occur in the
+/// PLY file are not read, leaving their destination untouched.
+///
+/// \param path path of the PLY file to read
+/// \param elements elements to read, see `plywoot::into()`
+/// \throws IoError in case the file could not be opened
+template<typename... Elements>
+void readElements(const std::string &path, const Elements &...elements)
+{
+  const auto open = [&path]() {
+    std::ifstream is{path, std::ios::binary};
+    if (!is) { throw IoError{"unable to open '" + path + "'"}; }
+    return is;
+  };
+
+  std::ifstream is = open();
+  IStream plyIs{is};
+
+  if (!plyIs.headerIndex() || sizeof...(Elements) < 2 || detail::maxThreads() < 2)
+  {
+    while (plyIs.hasElement())
+    {
+      const std::string name = plyIs.element().name();
+      bool read = false;
+      const auto readIfRequested = [&](const auto &element) {
+        if (!read && element.name() == name)
+        {
+          element.read(plyIs);
+          read = true;
+        }
+      };
+      (readIfRequested(elements), ...);
+
+      if (!read) { plyIs.skipElement(); }
+    }
+    return;
+  }
+
+  // Note; since all elements preceding some element have a fixed row size,
+  // finding an element only requires skipping a computed number of bytes.
+  const std::array<std::function<void()>, sizeof...(Elements)> tasks{[&open, &elements]() {
+    std::ifstream elementIs = open();
+    IStream elementPlyIs{elementIs};
+    if (elementPlyIs.find(elements.name())) { elements.read(elementPlyIs); }
+  }...};
+
+  detail::parallelFor(tasks.size(), detail::maxThreads(), [&tasks](std::size_t first, std::size_t last) {
+    for (std::size_t i = first; i < last; ++i) { tasks[i](); }
+  });
+}
+
+/// Creates an element to be written through `plywoot::write()` from the
+/// memory block described by the given layout. The memory block needs to
+/// remain valid until the element is written.
+///
+/// \param element PLY element to write
+/// \param layout PLY property to source type mapping representing the way PLY
+///     properties should be mapped from the various source type member types
+/// \return an element to be written through `plywoot::write()`
+template<typename... Ts>
+detail::LayoutElementWriter<Ts...> element(const PlyElement &element, const reflect::Layout<Ts...> layout)
+{
+  return {element, layout};
+}
+
+/// Creates an element to be written through `plywoot::write()` that takes
+/// ownership of the given element data, so the data does not need to be kept
+/// alive by the caller.
+///
+/// \param data element data to write
+/// \return an element to be written through `plywoot::write()`
+inline detail::DataElementWriter element(PlyElementData data)
+{
+  return {std::move(data)};
+}
+
+/// Writes the given elements as PLY data of the given format to the given
+/// output stream, in the order they are passed in. In contrast to `OStream`,
+/// the write loops of all elements are instantiated at compile time for every
+/// format, so that writing does not involve any type erasure or dispatching
+/// beyond a single switch on the format.
+///
+/// \param os output stream to write the PLY data to
+/// \param format format of the output PLY data
+/// \param elements elements to write, see `plywoot::element()`
+template<typename... Elements>
+void write(std::ostream &os, PlyFormat format, const Elements &...elements)
+{
+  detail::writeHeader(os, format, {}, {elements.element()...});
+
+  const auto writeElements = [&](auto writerType) {
+    typename decltype(writerType)::DestT writer{os};
+    (elements.write(writer), ...);
+
+    // Note; flush explicitly, so that write errors are reported here rather
+    // than being suppressed when the writer goes out of scope.
+    writer.flush();
+  };
+
+  switch (format)
+  {
+    case PlyFormat::Ascii:
+      writeElements(reflect::Type<detail::Writer<detail::AsciiWriterPolicy>>{});
+      break;
+    case PlyFormat::BinaryBigEndian:
+      writeElements(reflect::Type<detail::Writer<detail::BinaryBigEndianWriterPolicy>>{});
+      break;
+    case PlyFormat::BinaryLittleEndian:
+      writeElements(reflect::Type<detail::Writer<detail::BinaryLittleEndianWriterPolicy>>{});
+      break;
+  }
+}
+
 /// Converts the given input PLY stream to the requested format, and outputs the
-/// resulting PLY data to the given output stream.
+/// resulting PLY data to the given output stream. Element data is streamed
+/// from the input to the output stream in chunks of a bounded number of rows,
+/// so memory use does not depend on the size of the input data.
 ///
 /// \param is input stream containing the PLY data to convert
 /// \param os output stream to write converted PLY data to
@@ -358,18 +918,21 @@ private:
 inline void convert(std::istream &is, std::ostream &os, PlyFormat format)
 {
   IStream plyIs{is};
-  OStream plyOs{format};
 
-  // Note; preserve element data until the write() function below finishes.
-  std::vector<PlyElementData> elementsData;
+  detail::writeHeader(os, format, {}, plyIs.elements());
 
+  detail::WriterVariant writer{os, format};
   while (plyIs.hasElement())
   {
-    elementsData.emplace_back(plyIs.readElement());
-    plyOs.add(elementsData.back());
+    plyIs.readElementChunks(
+        ConvertRowsPerChunk,
+        [&writer](const PlyElementData &chunk) {
+          writer.write(chunk.element(), chunk.data(), chunk.alignment(), chunk.listArena());
+        },
+        PlyListStorage::Arena);
   }
 
-  plyOs.write(os);
+  writer.flush();
 }
 
 }
@@ -49,6 +49,22 @@ struct UnexpectedEof : ParserException
   UnexpectedEof() : ParserException("unexpected end of file") {}
 };
 
+/// Exception thrown in case a list property is read into a fixed size array,
+/// but the list in the input does not have the expected number of elements.
+struct InvalidListSize : ParserException
+{
+  /// Constructs an invalid list size exception.
+  ///
+  /// \param expected expected number of elements in the list
+  /// \param found number of elements in the list that was found in the input
+  InvalidListSize(std::size_t expected, long long found)
+      : ParserException(
+            "expected a list of size " + std::to_string(expected) + ", found a list of size " +
+            std::to_string(found))
+  {
+  }
+};
+
 namespace detail {
 
 /// Defines a parser policy that deals with ASCII input streams. The policy
@@ -62,6 +78,18 @@ public:
   /// \param is input stream to associate with this ASCII input stream policy.
   AsciiParserPolicy(std::istream &is) : is_{is} {}
 
+  /// Returns the position of the read head relative to the start of the
+  /// element data.
+  ///
+  /// \return the position of the read head
+  std::uint64_t position() const { return is_.position(); }
+
+  /// Positions the read head at the given position relative to the start of
+  /// the element data.
+  ///
+  /// \param position position to move the read head to
+  void seek(std::uint64_t position) const { is_.seek(position); }
+
   /// Skips the given element in the current input stream, assuming the read
   /// head is at the start of that element.
   ///
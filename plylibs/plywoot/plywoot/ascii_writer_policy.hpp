@@ -110,6 +110,9 @@ public:
   /// Writes a token separator (a space).
   void writeTokenSeparator() const { os_.put(' '); }
 
+  /// Writes all buffered data to the output stream.
+  void flush() const { os_.flush(); }
+
 private:
   mutable detail::BufferedOStream os_;
 };
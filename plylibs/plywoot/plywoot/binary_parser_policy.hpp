@@ -24,9 +24,11 @@
 
 #include "buffered_istream.hpp"
 #include "endian.hpp"
+#include "memory_istream.hpp"
 #include "type_traits.hpp"
 
 #include <cstdint>
+#include <cstring>
 #include <numeric>
 
 namespace plywoot::detail {
@@ -34,15 +36,43 @@ namespace plywoot::detail {
 /// Defines a parser policy that deals with binary input streams. The policy
 /// types act as mixins to add format specific behavior to the generic parser
 /// functionality in `plywoot::detail::Parser`.
-template<typename Endianness>
+///
+/// By default, data is read from a buffered standard input stream. In case the
+/// `IStream` type is `MemoryIStream`, data is read from a block of memory
+/// instead, which is used to decode blocks of raw element data on multiple
+/// threads.
+template<typename Endianness, typename IStream = BufferedIStream>
 class BinaryParserPolicy
 {
 public:
+  /// Endianness of the binary data parsed by this policy.
+  using EndiannessType = Endianness;
+
   /// Constructs a binary little endian parser policy.
   ///
   /// \param is input stream to associate with this binary input stream policy.
   BinaryParserPolicy(std::istream &is) : is_{is} {}
 
+  /// Constructs a binary parser policy reading from the memory block in the
+  /// range [`first`, `last`). Only available in case `IStream` is
+  /// `MemoryIStream`.
+  ///
+  /// \param first pointer to the start of the memory block to parse
+  /// \param last pointer to one byte past the end of the memory block to parse
+  BinaryParserPolicy(const std::uint8_t *first, const std::uint8_t *last) : is_{first, last} {}
+
+  /// Returns the position of the read head relative to the start of the
+  /// element data. Only available in case `IStream` is `BufferedIStream`.
+  ///
+  /// \return the position of the read head
+  std::uint64_t position() const { return is_.position(); }
+
+  /// Positions the read head at the given position relative to the start of
+  /// the element data. Only available in case `IStream` is `BufferedIStream`.
+  ///
+  /// \param position position to move the read head to
+  void seek(std::uint64_t position) const { is_.seek(position); }
+
   /// Skips the given element in the current input stream, assuming the read
   /// head is at the start of that element.
   ///
@@ -117,8 +147,8 @@ public:
   template<typename T, typename EndiannessDependent = Endianness>
   T readNumber() const
   {
-    if constexpr (std::is_same_v<EndiannessDependent, HostEndian>) { return is_.read<T>(); }
-    else { return byte_swap(is_.read<T>()); }
+    if constexpr (std::is_same_v<EndiannessDependent, HostEndian>) { return is_.template read<T>(); }
+    else { return byte_swap(is_.template read<T>()); }
   }
 
   /// Reads `N` numbers of the given type `PlyT` from the input stream, and
@@ -132,16 +162,19 @@ public:
   template<typename PlyT, typename DestT, std::size_t N, typename EndiannessDependent = Endianness>
   std::uint8_t *readNumbers(std::uint8_t *dest) const
   {
-    if constexpr (std::is_same_v<EndiannessDependent, HostEndian>) { return is_.read<PlyT, DestT, N>(dest); }
+    if constexpr (std::is_same_v<EndiannessDependent, HostEndian>) { return is_.template read<PlyT, DestT, N>(dest); }
     else
     {
-      std::uint8_t *result = is_.read<PlyT, DestT, N>(dest);
+      // Note; endianness conversion needs to happen before the numbers are
+      // converted to the destination type.
+      PlyT from[N];
+      is_.template read<PlyT, PlyT, N>(reinterpret_cast<std::uint8_t *>(from));
 
-      // Perform endianess conversion.
-      DestT *to = reinterpret_cast<DestT *>(dest);
-      for (std::size_t i = 0; i < N; ++i, ++to) { *to = static_cast<DestT>(byte_swap(static_cast<PlyT>(*to))); }
+      DestT to[N];
+      for (std::size_t i = 0; i < N; ++i) { to[i] = static_cast<DestT>(byte_swap(from[i])); }
+      std::memcpy(dest, to, N * sizeof(DestT));
 
-      return result;
+      return dest + N * sizeof(DestT);
     }
   }
 
@@ -157,6 +190,14 @@ public:
   /// \param n number of bytes to skip
   void skipProperties(std::size_t n) const { is_.skip(n); }
 
+  /// Copies the next \p n bytes of raw, unconverted data from the input stream
+  /// to the given destination buffer.
+  ///
+  /// \param dest pointer to the destination in memory, which should be able to
+  ///     hold at least \p n bytes
+  /// \param n number of bytes to copy
+  void readRaw(std::uint8_t *dest, std::size_t n) const { is_.memcpy(dest, n); }
+
   /// Copies all element data to the given destination buffer `dest`. This
   /// assumes an element maps to a collection of types `Ts...` for which all
   /// types are trivially copyable, and contiguous in memory without any padding
@@ -171,42 +212,18 @@ public:
 
     if constexpr (!std::is_same_v<EndiannessDependent, HostEndian>)
     {
-      for (std::size_t i = 0; i < element.size(); ++i) { dest = byteSwap<Ts...>(dest); }
-    }
-  }
-
-private:
-  template<typename T>
-  std::uint8_t *byteSwap(std::uint8_t *dest) const
-  {
-    if constexpr (!detail::IsPack<T>::value)
-    {
-      auto ptr = reinterpret_cast<T *>(dest);
-      *ptr = byte_swap(*ptr);
+      static_assert(
+          detail::isPacked<Ts...>(), "converting endianness of possibly padded range of objects not implemented yet");
 
-      return dest + sizeof(T);
+      const ByteSwapRows byteSwapRows{
+          detail::fixedRowNumberSizes<Ts...>(element.properties().begin(), element.properties().end())};
+      byteSwapRows(dest, element.size());
     }
-    else
-    {
-      auto ptr = reinterpret_cast<typename T::DestT *>(dest);
-      for (std::size_t i = 0; i < T::size; ++i, ++ptr) { *ptr = byte_swap(*ptr); }
-
-      return dest + detail::sizeOf<T>();
-    }
-  }
-
-  template<typename T, typename U, typename... Ts>
-  std::uint8_t *byteSwap(std::uint8_t *dest) const
-  {
-    static_assert(
-        detail::isPacked<T, U, Ts...>(),
-        "converting endianness of possibly padded range of objects not implemented yet");
-
-    return byteSwap<U, Ts...>(byteSwap<T>(dest));
   }
 
+private:
   /// Wrapped input stream associated with this binary parser policy.
-  mutable detail::BufferedIStream is_;
+  mutable IStream is_;
 };
 
 /// Convenience type alias for the binary little endian parser policy.
@@ -214,6 +231,25 @@ using BinaryLittleEndianParserPolicy = BinaryParserPolicy<LittleEndian>;
 /// Convenience type alias for the binary big endian parser policy.
 using BinaryBigEndianParserPolicy = BinaryParserPolicy<BigEndian>;
 
+/// Type function that maps a binary parser policy reading from a buffered
+/// input stream on a binary parser policy reading from a block of memory in
+/// host byte order; blocks of data in the other byte order are converted in
+/// bulk before they are decoded, see `ByteSwapRows`. For all other parser
+/// policies, the resulting type is `void`.
+/// @{
+template<typename Policy>
+struct ToMemoryParserPolicy
+{
+  using type = void;
+};
+
+template<typename Endianness>
+struct ToMemoryParserPolicy<BinaryParserPolicy<Endianness, BufferedIStream>>
+{
+  using type = BinaryParserPolicy<HostEndian, MemoryIStream>;
+};
+/// @}
+
 }
 
 #endif
@@ -25,6 +25,8 @@
 #include "buffered_ostream.hpp"
 #include "endian.hpp"
 
+#include <algorithm>
+#include <cstdint>
 #include <ostream>
 
 namespace plywoot::detail {
@@ -34,6 +36,8 @@ template<typename Endianness>
 class BinaryWriterPolicy
 {
 public:
+  using EndiannessType = Endianness;
+
   BinaryWriterPolicy(std::ostream &os) : os_{os} {}
 
   /// Writes the number `t` of the given type `T` to the given binary output
@@ -78,6 +82,36 @@ public:
     }
   }
 
+  /// Writes \p n bytes starting at \p src to the binary output stream as is,
+  /// assuming the data is already in the right binary representation. Large
+  /// blocks of data bypass the output buffer.
+  void writeRaw(const std::uint8_t *src, std::size_t n) const
+  {
+    os_.write(reinterpret_cast<const char *>(src), n);
+  }
+
+  /// Writes \p n rows of data starting at \p src, where every row in the
+  /// source buffer occupies \p srcRowSize bytes, and \p destRowSize bytes in
+  /// the binary output stream. Rows are converted in large blocks directly
+  /// into the output buffer, by calling `transform(src, numRows, dest)`.
+  template<typename Transform>
+  void writeRows(
+      const std::uint8_t *src,
+      std::size_t n,
+      std::size_t srcRowSize,
+      std::size_t destRowSize,
+      Transform transform) const
+  {
+    const std::size_t rowsPerBlock = std::max<std::size_t>(1, OStreamBufferSize / 2 / destRowSize);
+    while (n > 0)
+    {
+      const std::size_t numRows = std::min(rowsPerBlock, n);
+      transform(src, numRows, reinterpret_cast<std::uint8_t *>(os_.claim(numRows * destRowSize)));
+      src += numRows * srcRowSize;
+      n -= numRows;
+    }
+  }
+
   /// Outputs empty data for the range of properties [`first`, `last`). Note
   /// that a property that is undefined is always stored as a zero number, where
   /// the type of the number depends on the underlying property; in case of a
@@ -123,6 +157,9 @@ public:
   /// Writes a token separator, ignored for binary output formats.
   void writeTokenSeparator() const {}
 
+  /// Writes all buffered data to the output stream.
+  void flush() const { os_.flush(); }
+
 private:
   mutable detail::BufferedOStream os_;
 };
@@ -22,6 +22,8 @@
 
 /// \file
 
+#include "endian.hpp"
+
 #include <algorithm>
 #include <cstdint>
 #include <cstring>
@@ -37,6 +39,64 @@ constexpr std::size_t IStreamBufferSize{1024 * 1024};
 
 namespace plywoot::detail {
 
+/// Returns the number of bits set in the given 16-bit mask.
+///
+/// \param mask mask to count the set bits of
+/// \return the number of bits set in \p mask
+inline unsigned popcount16(unsigned mask)
+{
+  mask = mask - ((mask >> 1) & 0x5555u);
+  mask = (mask & 0x3333u) + ((mask >> 2) & 0x3333u);
+  mask = (mask + (mask >> 4)) & 0x0f0fu;
+  return (mask + (mask >> 8)) & 0x1fu;
+}
+
+/// Searches the range [`first`, `last`) for the \p n-th newline character.
+/// In case it is found, returns a pointer to the character following it, and
+/// sets \p n to zero. Otherwise, returns `last`, and decreases \p n by the
+/// number of newline characters in the range. Where available, newlines are
+/// counted 16 characters at a time using SSE2.
+///
+/// \param first pointer to the first character in the range
+/// \param last pointer one past the last character in the range
+/// \param n number of newline characters to skip, at least one
+/// \return a pointer to the character following the \p n-th newline
+///     character, or `last`
+inline const char *skipNewlines(const char *first, const char *last, std::size_t &n)
+{
+#ifdef PLYWOOT_HAS_SSE2
+  const __m128i newline = _mm_set1_epi8('\n');
+  for (; last - first >= 16; first += 16)
+  {
+    const __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i *>(first));
+    unsigned mask = static_cast<unsigned>(_mm_movemask_epi8(_mm_cmpeq_epi8(chunk, newline)));
+
+    const unsigned count = popcount16(mask);
+    if (count >= n)
+    {
+      // Clear the lowest n - 1 set bits; the lowest remaining set bit then
+      // corresponds to the n-th newline character.
+      for (; n > 1; --n) { mask &= mask - 1; }
+
+      unsigned offset = 0;
+      while (!(mask & (1u << offset))) { ++offset; }
+
+      n = 0;
+      return first + offset + 1;
+    }
+
+    n -= count;
+  }
+#endif
+
+  for (; first != last; ++first)
+  {
+    if (*first == '\n' && --n == 0) { return first + 1; }
+  }
+
+  return last;
+}
+
 /// Wrapper around some input stream that provides buffered input functionality.
 /// This will always buffer some compile-time given size of bytes up front, and
 /// data is read from this buffer until the buffer is exhausted, at which point
@@ -46,12 +106,39 @@ class BufferedIStream
 {
 public:
   /// Constructs a buffered input stream wrapper around the given input stream.
-  explicit BufferedIStream(std::istream &is) : is_{is} { buffer(); }
+  explicit BufferedIStream(std::istream &is) : is_{is}, start_{is.tellg()} { buffer(); }
 
   /// No copy semantics allowed.
   BufferedIStream(const BufferedIStream &) = delete;
   BufferedIStream &operator=(const BufferedIStream &) = delete;
 
+  /// Returns the position of the read head, as the number of bytes relative to
+  /// the position of the wrapped input stream at construction.
+  ///
+  /// \return the position of the read head
+  std::uint64_t position() const { return pos_ - (valid_ - c_); }
+
+  /// Positions the read head at the given position, as the number of bytes
+  /// relative to the position of the wrapped input stream at construction. In
+  /// case the position is not in the range of buffered data, this requires the
+  /// wrapped input stream to be seekable.
+  ///
+  /// \param position position to move the read head to
+  void seek(std::uint64_t position)
+  {
+    const std::uint64_t bufferStart = pos_ - (valid_ - buffer_.get());
+    if (bufferStart <= position && position < pos_)
+    {
+      c_ = buffer_.get() + (position - bufferStart);
+      return;
+    }
+
+    is_.clear();
+    is_.seekg(start_ + static_cast<std::streamoff>(position));
+    pos_ = position;
+    buffer();
+  }
+
   /// Returns whether the read head is at the end of the stream.
   bool eof() const { return *c_ == EOF; }
 
@@ -113,7 +200,8 @@ public:
       const std::size_t remaining = eob_ - c_;
       std::memcpy(dest, c_, remaining);
       is_.read(reinterpret_cast<char *>(dest) + remaining, n - remaining);
-      c_ = eob_;
+      pos_ += n - remaining;
+      c_ = valid_ = eob_;
     }
     else
     {
@@ -134,25 +222,26 @@ public:
     else
     {
       is_.seekg(n - remaining, std::ios_base::cur);
+      pos_ += n - remaining;
       buffer();
     }
   }
 
   /// Skips `n` lines in the input, places the read head at the first
   /// character after the `n`-th newline character that as found in the input,
-  /// or in case that character does not exist, at EOF.
+  /// or in case that character does not exist, at EOF. Newlines are counted in
+  /// bulk for all buffered data, see `skipNewlines()`.
   void skipLines(std::size_t n)
   {
-    while (*c_ != EOF && n > 0)
+    while (n > 0)
     {
-      c_ = static_cast<const char *>(std::memchr(c_, '\n', eob_ - c_));
-      if (c_)
-      {
-        readCharacter();
-        --n;
-      }
-      else { buffer(); }
+      if (c_ == eob_) { buffer(); }
+      if (*c_ == EOF) { return; }
+
+      c_ = skipNewlines(c_, eob_, n);
     }
+
+    if (c_ == eob_) { buffer(); }
   }
 
   /// Skips whitespace in the input stream, and positions the read head on the
@@ -180,15 +269,21 @@ public:
     std::size_t remaining = eob_ - c_;
     if (remaining < minimum)
     {
+      const std::size_t validRemaining = valid_ > c_ ? valid_ - c_ : 0;
+      std::size_t numRead = IStreamBufferSize - remaining;
+
       std::memcpy(buffer_.get(), c_, remaining);
       if (!is_.read(buffer_.get() + remaining, IStreamBufferSize - remaining))
       {
         // In case the buffer is only partially filled, fill the remainder with
         // EOF characters.
-        remaining += is_.gcount();
+        numRead = is_.gcount();
+        remaining += numRead;
         std::fill_n(buffer_.get() + remaining, IStreamBufferSize - remaining, static_cast<char>(EOF));
       }
 
+      pos_ += numRead;
+      valid_ = buffer_.get() + validRemaining + numRead;
       c_ = buffer_.get();
     }
   }
@@ -197,14 +292,17 @@ private:
   /// Unconditionally buffers data from the input stream.
   void buffer()
   {
+    std::size_t numRead = IStreamBufferSize;
     if (!is_.read(buffer_.get(), IStreamBufferSize))
     {
       // In case the buffer is only partially filled, fill the remainder with
       // EOF characters.
-      auto remaining = is_.gcount();
-      std::fill_n(buffer_.get() + remaining, IStreamBufferSize - remaining, static_cast<char>(EOF));
+      numRead = is_.gcount();
+      std::fill_n(buffer_.get() + numRead, IStreamBufferSize - numRead, static_cast<char>(EOF));
     }
 
+    pos_ += numRead;
+    valid_ = buffer_.get() + numRead;
     c_ = buffer_.get();
   }
 
@@ -227,9 +325,17 @@ private:
   const char *c_{buffer_.get() + IStreamBufferSize};
   /// Number of bytes remaining in the buffer.
   const char *eob_{buffer_.get() + IStreamBufferSize};
+  /// Points one past the last byte in the buffer that was read from the
+  /// wrapped input stream; beyond it, the buffer is filled with EOF characters.
+  const char *valid_{buffer_.get() + IStreamBufferSize};
 
   /// Reference to the wrapped standard input stream.
   std::istream &is_;
+  /// Position of the wrapped input stream at construction.
+  std::streamoff start_;
+  /// Position of the wrapped input stream relative to `start_`, corresponding
+  /// to `valid_`.
+  std::uint64_t pos_{0};
 };
 
 }
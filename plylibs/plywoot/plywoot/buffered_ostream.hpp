@@ -52,9 +52,22 @@ public:
   /// stream.
   explicit BufferedOStream(std::ostream &os) : os_{os} {}
 
-  /// Destructs this buffered output stream, ensures the wrapped stream is
-  /// closed.
-  ~BufferedOStream() { flush(); }
+  /// Destructs this buffered output stream, writing any data that is still
+  /// buffered to the wrapped stream. Errors are not reported from here, since
+  /// the destructor cannot throw; call `flush()` explicitly beforehand in case
+  /// write errors need to be detected.
+  ~BufferedOStream()
+  {
+    if (os_.bad()) return;
+
+    try
+    {
+      flush();
+    }
+    catch (...)
+    {
+    }
+  }
 
   /// No copy semantics allowed.
   BufferedOStream(const BufferedOStream &) = delete;
@@ -84,6 +97,17 @@ public:
     }
   }
 
+  /// Claims \p n bytes in the output buffer, to be filled in directly by the
+  /// caller, and returns a pointer to the first claimed byte. The number of
+  /// bytes to claim needs to be smaller than the buffer size.
+  char *claim(std::size_t n)
+  {
+    if (c_ + n >= eob_) { flush(); }
+    char *result = c_;
+    c_ += n;
+    return result;
+  }
+
   /// Writes a number of type `T` to the output stream.
   template<typename T>
   void writeAscii(T t)
@@ -102,7 +126,6 @@ public:
     c_ += sizeof(T);
   }
 
-private:
   /// Flushes the output buffer to the underlying output stream.
   void flush()
   {
@@ -110,6 +133,8 @@ private:
     c_ = buffer_.get();
   }
 
+private:
+
   /// Buffered data, always a null terminated string.
   std::unique_ptr<char[]> buffer_{new char[OStreamBufferSize]};
 
@@ -22,14 +22,65 @@
 
 /// \file
 
+#include "type_traits.hpp"
 #include "types.hpp"
 
 #include <algorithm>
+#include <cstring>
 #include <memory>
+#include <utility>
 #include <vector>
 
 namespace plywoot {
 
+namespace detail {
+
+template<typename FormatParserPolicy>
+class Parser;
+
+/// Type tag used by the parser and writer to read or write a variable length
+/// list property of type `T` from or to a list arena, see
+/// `PlyListStorage::Arena`. The arena is passed along with the tag, either as
+/// a pointer to the arena that is being filled while parsing, or as a pointer
+/// to the start of the arena when writing.
+template<typename T, typename ArenaPtr>
+struct ArenaList
+{
+  /// Type of the values in the list.
+  using DestT = T;
+
+  /// List arena to read the list values into, or write them from.
+  ArenaPtr arena;
+};
+
+template<typename T, typename ArenaPtr>
+struct IsList<ArenaList<T, ArenaPtr>>
+{
+  static constexpr bool value = true;
+};
+
+}
+
+/// Defines how `PlyElementData` stores variable length list properties.
+enum class PlyListStorage {
+  /// Every list of every row is stored in its own `std::vector`.
+  Vector,
+  /// The values of all lists are stored contiguously in a single memory arena;
+  /// every row refers to its lists through `PlyListRef` instances.
+  Arena,
+};
+
+/// Refers to the values of a single list stored in the list arena of some
+/// `PlyElementData` instance.
+struct PlyListRef
+{
+  /// Offset in bytes of the first list value relative to the start of the
+  /// list arena.
+  std::size_t offset;
+  /// Number of values in the list.
+  std::size_t size;
+};
+
 /// Abstracts a block of memory representing storing all data in a PLY element
 /// mapping the data types used in the PLY file directly on native types.
 class PlyElementData
@@ -40,11 +91,14 @@ public:
 
   /// Constructs an element data block for the given PLY element. Calculates the
   /// total size in bytes of the data block to represent all data in the given
-  /// PLY element. Note that lists are mapped on to `std::vector`, so we can
-  /// pre-calculate the data size of the data block.
+  /// PLY element. Note that lists are mapped on to either an `std::vector` or
+  /// a `PlyListRef`, depending on \p listStorage, so we can pre-calculate the
+  /// data size of the data block.
   ///
   /// \param element PLY element to construct this instance for
-  explicit PlyElementData(const PlyElement &element) : element_{element}
+  /// \param listStorage defines how variable length lists are stored
+  explicit PlyElementData(const PlyElement &element, PlyListStorage listStorage = PlyListStorage::Vector)
+      : element_{element}, listStorage_{listStorage}
   {
     // Keep track of the alignment requirements of the memory block that will
     // store all element data. Store the relative offsets of every manually
@@ -52,7 +106,13 @@ public:
     const std::vector<PlyProperty> &properties = element_.properties();
     for (const PlyProperty &property : properties)
     {
-      if (property.isList())
+      if (property.isList() && listStorage_ == PlyListStorage::Arena)
+      {
+        listOffsets_.push_back(detail::align(bytesPerElement_, alignof(PlyListRef)));
+        bytesPerElement_ = listOffsets_.back() + sizeof(PlyListRef);
+        alignment_ = std::max(alignment_, alignof(PlyListRef));
+      }
+      else if (property.isList())
       {
         // Note, the exact type of the vector element does not matter here.
         listOffsets_.push_back(detail::align(bytesPerElement_, alignof(std::vector<int>)));
@@ -98,6 +158,15 @@ public:
     // data.
     data_ = std::unique_ptr<std::uint8_t[]>(new std::uint8_t[element_.size() * bytesPerElement_]);
 
+    // In case of arena storage, list values are appended to the arena while
+    // parsing. Note; always allocate some storage, such that `listArena()` is
+    // never null in case of arena storage.
+    if (listStorage_ == PlyListStorage::Arena)
+    {
+      listArena_.reserve(ListArenaInitialCapacity);
+      return;
+    }
+
     // Finally, allocate all vectors holding the variable length list
     // properties.
     auto listOffset = listOffsets_.begin();
@@ -144,6 +213,8 @@ public:
   /// Destructor, deallocates all vectors holding the variable length lists.
   ~PlyElementData()
   {
+    if (listStorage_ == PlyListStorage::Arena) return;
+
     auto listOffset = listOffsets_.begin();
     for (const PlyProperty &property : element_.properties())
     {
@@ -207,6 +278,8 @@ public:
     listOffsets_ = std::move(x.listOffsets_);
     bytesPerElement_ = x.bytesPerElement_;
     alignment_ = x.alignment_;
+    listStorage_ = x.listStorage_;
+    listArena_ = std::move(x.listArena_);
 
     x.bytesPerElement_ = 0;
     x.listOffsets_.clear();
@@ -233,7 +306,60 @@ public:
   ///     block in bytes
   std::size_t alignment() const { return alignment_; }
 
+  /// Returns the number of bytes between two consecutive rows in the memory
+  /// block storing element data.
+  ///
+  /// \return the number of bytes required to store a single row
+  std::size_t bytesPerElement() const { return bytesPerElement_; }
+
+  /// Returns how variable length lists are stored in this memory block.
+  ///
+  /// \return how variable length lists are stored in this memory block
+  PlyListStorage listStorage() const { return listStorage_; }
+
+  /// Returns a pointer to the start of the list arena storing the values of all
+  /// variable length lists, in case of `PlyListStorage::Arena`. The
+  /// `PlyListRef::offset` member of every list refers to this pointer. For
+  /// `PlyListStorage::Vector`, returns `nullptr`.
+  ///
+  /// \return a pointer to the start of the list arena, or `nullptr`
+  const std::uint8_t *listArena() const
+  {
+    return listStorage_ == PlyListStorage::Arena ? listArena_.data() : nullptr;
+  }
+
+  /// Returns the values of a variable length list, regardless of the list
+  /// storage type. The list is identified by the row in the element, and the
+  /// index of the list property counting list properties only.
+  ///
+  /// \param row row in the element to return a list for
+  /// \param listIndex index of the list property, where only list properties
+  ///     are counted
+  /// \tparam T native type of the values in the list, matching the PLY type
+  /// \return a pointer to the first value in the list, and the number of
+  ///     values in the list
+  template<typename T>
+  std::pair<const T *, std::size_t> list(std::size_t row, std::size_t listIndex) const
+  {
+    const std::uint8_t *ptr = data_.get() + row * bytesPerElement_ + listOffsets_[listIndex];
+    if (listStorage_ == PlyListStorage::Arena)
+    {
+      PlyListRef ref;
+      std::memcpy(&ref, ptr, sizeof(PlyListRef));
+      return {reinterpret_cast<const T *>(listArena_.data() + ref.offset), ref.size};
+    }
+
+    const std::vector<T> &v = *reinterpret_cast<const std::vector<T> *>(ptr);
+    return {v.data(), v.size()};
+  }
+
 private:
+  template<typename FormatParserPolicy>
+  friend class detail::Parser;
+
+  /// Initial capacity in bytes of the list arena; may need tweaking.
+  static constexpr std::size_t ListArenaInitialCapacity{4096};
+
   /// Definition of the element associated with this element data instance.
   PlyElement element_;
   /// Memory block containing all properties of the elements to store
@@ -246,6 +372,11 @@ private:
   /// Alignment requirements of the elements stored in this memory block in
   /// bytes.
   std::size_t alignment_ = alignof(char);
+  /// Defines how variable length lists are stored.
+  PlyListStorage listStorage_ = PlyListStorage::Vector;
+  /// Memory arena storing the values of all variable length lists, in case of
+  /// `PlyListStorage::Arena`.
+  std::vector<std::uint8_t> listArena_;
 };
 
 }
@@ -0,0 +1,108 @@
+/*
+   This file is part of PLYwoot, a header-only PLY parser.
+
+   Copyright (C) 2023-2026, Ton van den Heuvel
+
+   PLYwoot is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef PLYWOOT_ELEMENT_READER_HPP
+#define PLYWOOT_ELEMENT_READER_HPP
+
+/// \file
+
+#include "element_data.hpp"
+
+#include <string>
+#include <vector>
+
+namespace plywoot::detail {
+
+/// Element to be read into a list of objects of type `T`, where the `Layout`
+/// type is used to identify how properties from the PLY element are mapped on
+/// objects of type `T`, see `plywoot::into()`.
+template<typename T, typename Layout>
+class LayoutElementReader
+{
+public:
+  /// Constructs an element reader for the element with the given name.
+  ///
+  /// \param name name of the element to read
+  /// \param dest list of objects to store the element data in
+  LayoutElementReader(std::string name, std::vector<T> &dest) : name_{std::move(name)}, dest_{dest} {}
+
+  /// Returns the name of the element to read.
+  ///
+  /// \return the name of the element to read
+  const std::string &name() const { return name_; }
+
+  /// Reads the current element from the given input stream.
+  ///
+  /// \param is input stream of which the current element is the element to
+  ///     read
+  template<typename IStream>
+  void read(const IStream &is) const
+  {
+    dest_ = is.template readElement<T, Layout>();
+  }
+
+private:
+  /// Name of the element to read.
+  std::string name_;
+  /// List of objects to store the element data in.
+  std::vector<T> &dest_;
+};
+
+/// Element to be read into a `PlyElementData` instance, see
+/// `plywoot::into()`.
+class DataElementReader
+{
+public:
+  /// Constructs an element reader for the element with the given name.
+  ///
+  /// \param name name of the element to read
+  /// \param dest element data instance to store the element data in
+  /// \param listStorage defines how variable length lists are stored
+  DataElementReader(std::string name, PlyElementData &dest, PlyListStorage listStorage)
+      : name_{std::move(name)}, dest_{dest}, listStorage_{listStorage}
+  {
+  }
+
+  /// Returns the name of the element to read.
+  ///
+  /// \return the name of the element to read
+  const std::string &name() const { return name_; }
+
+  /// Reads the current element from the given input stream.
+  ///
+  /// \param is input stream of which the current element is the element to
+  ///     read
+  template<typename IStream>
+  void read(const IStream &is) const
+  {
+    dest_ = is.readElement(listStorage_);
+  }
+
+private:
+  /// Name of the element to read.
+  std::string name_;
+  /// Element data instance to store the element data in.
+  PlyElementData &dest_;
+  /// Defines how variable length lists are stored.
+  PlyListStorage listStorage_;
+};
+
+}
+
+#endif
@@ -0,0 +1,103 @@
+/*
+   This file is part of PLYwoot, a header-only PLY parser.
+
+   Copyright (C) 2023-2026, Ton van den Heuvel
+
+   PLYwoot is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef PLYWOOT_ELEMENT_WRITER_HPP
+#define PLYWOOT_ELEMENT_WRITER_HPP
+
+/// \file
+
+#include "element_data.hpp"
+#include "reflect.hpp"
+#include "types.hpp"
+
+#include <utility>
+
+namespace plywoot::detail {
+
+/// Element to be written from some memory block described by a layout, see
+/// `plywoot::element()`.
+template<typename... Ts>
+class LayoutElementWriter
+{
+public:
+  /// Constructs an element writer for the given element and layout. The size
+  /// of the element that is written equals the number of items in the layout.
+  ///
+  /// \param element PLY element to write
+  /// \param layout PLY property to source type mapping
+  LayoutElementWriter(const PlyElement &element, reflect::Layout<Ts...> layout)
+      : element_{element.name(), layout.size(), element.properties()}, layout_{layout}
+  {
+  }
+
+  /// Returns the element definition to write to the PLY header.
+  ///
+  /// \return the element definition to write to the PLY header
+  const PlyElement &element() const { return element_; }
+
+  /// Writes the element data using the given writer.
+  ///
+  /// \param writer writer to write the element data with
+  template<typename Writer>
+  void write(const Writer &writer) const
+  {
+    writer.write(element_, layout_);
+  }
+
+private:
+  /// Element definition, of which the size equals the number of items in the
+  /// layout.
+  PlyElement element_;
+  /// Memory block to write the element data from.
+  reflect::Layout<Ts...> layout_;
+};
+
+/// Element to be written from an owned `PlyElementData` instance, see
+/// `plywoot::element()`.
+class DataElementWriter
+{
+public:
+  /// Constructs an element writer that takes ownership of the given element
+  /// data.
+  ///
+  /// \param data element data to write
+  DataElementWriter(PlyElementData data) : data_{std::move(data)} {}
+
+  /// Returns the element definition to write to the PLY header.
+  ///
+  /// \return the element definition to write to the PLY header
+  const PlyElement &element() const { return data_.element(); }
+
+  /// Writes the element data using the given writer.
+  ///
+  /// \param writer writer to write the element data with
+  template<typename Writer>
+  void write(const Writer &writer) const
+  {
+    writer.write(data_.element(), data_.data(), data_.alignment(), data_.listArena());
+  }
+
+private:
+  /// Element data to write.
+  PlyElementData data_;
+};
+
+}
+
+#endif
@@ -22,8 +22,26 @@
 
 /// \file
 
+#include <cstdint>
+#include <cstring>
 #include <type_traits>
 #include <utility>
+#include <vector>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define PLYWOOT_HAS_SSE2
+#include <emmintrin.h>
+#endif
+
+#if defined(__SSSE3__) || defined(__AVX__)
+#define PLYWOOT_HAS_SSSE3
+#include <tmmintrin.h>
+#endif
+
+#if defined(__ARM_NEON) && defined(__aarch64__)
+#define PLYWOOT_HAS_NEON
+#include <arm_neon.h>
+#endif
 
 namespace plywoot::detail {
 
@@ -74,6 +92,221 @@ T byte_swap(T t)
   return t;
 }
 
+#ifdef PLYWOOT_HAS_SSE2
+/// Swaps the bytes of every `Size`-byte lane in the given vector, to convert
+/// all numbers of size `Size` in the vector between endian representations.
+///
+/// \param v vector of numbers to convert
+/// \return \p v with all numbers converted from either big/little to
+///     little/big endian
+template<std::size_t Size>
+inline __m128i byteSwapLanes(__m128i v)
+{
+  static_assert(Size == 1 || Size == 2 || Size == 4 || Size == 8, "unsupported lane size");
+
+  if constexpr (Size > 1) { v = _mm_or_si128(_mm_slli_epi16(v, 8), _mm_srli_epi16(v, 8)); }
+  if constexpr (Size > 2)
+  {
+    v = _mm_shufflehi_epi16(_mm_shufflelo_epi16(v, _MM_SHUFFLE(2, 3, 0, 1)), _MM_SHUFFLE(2, 3, 0, 1));
+  }
+  if constexpr (Size > 4) { v = _mm_shuffle_epi32(v, _MM_SHUFFLE(2, 3, 0, 1)); }
+
+  return v;
+}
+#endif
+
+/// Converts rows of packed numbers in place between endian representations,
+/// where every row consists of the same sequence of numbers, possibly of
+/// different sizes. The conversion is compiled once into byte shuffles of at
+/// most 16 bytes, which are applied using SSSE3 or NEON table lookups where
+/// available. In case all numbers have the same size, all rows are treated as
+/// one contiguous array of numbers, which is converted 16 bytes at a time,
+/// also when only SSE2 is available.
+class ByteSwapRows
+{
+public:
+  /// Constructs a byte swapper for rows consisting of numbers of the given
+  /// sizes, in order.
+  ///
+  /// \param sizes size in bytes of every number in a row; either 1, 2, 4, or 8
+  explicit ByteSwapRows(std::vector<std::size_t> sizes) : sizes_{std::move(sizes)}
+  {
+    for (const std::size_t size : sizes_) { rowSize_ += size; }
+
+    numberSize_ = sizes_.empty() ? 1 : sizes_.front();
+    for (const std::size_t size : sizes_)
+    {
+      if (size != numberSize_) { numberSize_ = 0; }
+    }
+
+    if (numberSize_ > 0)
+    {
+      // Note; 16 is a multiple of the number size, so every 16-byte block of
+      // the array of numbers uses the same shuffle.
+      Shuffle block{0, {}};
+      for (std::size_t i = 0; i < 16; ++i) { block.mask[i] = swappedIndex(i - i % numberSize_, numberSize_, i); }
+      shuffles_.push_back(block);
+      return;
+    }
+
+    // Greedily group consecutive numbers in shuffles of at most 16 bytes. Bytes
+    // in a shuffle that do not belong to any of its numbers are left in place.
+    std::size_t offset = 0;
+    for (const std::size_t size : sizes_)
+    {
+      if (size > 1)
+      {
+        if (shuffles_.empty() || offset + size > shuffles_.back().offset + 16)
+        {
+          Shuffle block{offset, {}};
+          for (std::size_t i = 0; i < 16; ++i) { block.mask[i] = static_cast<std::uint8_t>(i); }
+          shuffles_.push_back(block);
+        }
+
+        Shuffle &block = shuffles_.back();
+        for (std::size_t i = offset; i < offset + size; ++i)
+        {
+          block.mask[i - block.offset] = swappedIndex(offset - block.offset, size, i - block.offset);
+        }
+      }
+
+      offset += size;
+    }
+  }
+
+  /// Converts the given number of rows in place.
+  ///
+  /// \param data pointer to the first row
+  /// \param n number of rows to convert
+  void operator()(std::uint8_t *data, std::size_t n) const
+  {
+    if (shuffles_.empty() || numberSize_ == 1) return;
+
+    const std::size_t numBytes = n * rowSize_;
+    if (numberSize_ > 0)
+    {
+      std::size_t i = 0;
+#if defined(PLYWOOT_HAS_SSSE3) || defined(PLYWOOT_HAS_NEON)
+      for (; i + 16 <= numBytes; i += 16) { shuffle(data + i, shuffles_.front().mask); }
+#elif defined(PLYWOOT_HAS_SSE2)
+      for (; i + 16 <= numBytes; i += 16)
+      {
+        __m128i *v = reinterpret_cast<__m128i *>(data + i);
+        switch (numberSize_)
+        {
+          case 2:
+            _mm_storeu_si128(v, byteSwapLanes<2>(_mm_loadu_si128(v)));
+            break;
+          case 4:
+            _mm_storeu_si128(v, byteSwapLanes<4>(_mm_loadu_si128(v)));
+            break;
+          default:
+            _mm_storeu_si128(v, byteSwapLanes<8>(_mm_loadu_si128(v)));
+            break;
+        }
+      }
+#endif
+      for (; i < numBytes; i += numberSize_) { swapNumber(data + i, numberSize_); }
+      return;
+    }
+
+    std::size_t row = 0;
+#if defined(PLYWOOT_HAS_SSSE3) || defined(PLYWOOT_HAS_NEON)
+    // Note; shuffles may extend into the next row, in which case those bytes
+    // are left untouched. Rows for which the last shuffle would extend beyond
+    // the last row are handled by the scalar loop.
+    const std::size_t reach = shuffles_.back().offset + 16;
+    for (; row * rowSize_ + reach <= numBytes; ++row)
+    {
+      std::uint8_t *r = data + row * rowSize_;
+      for (const Shuffle &s : shuffles_) { shuffle(r + s.offset, s.mask); }
+    }
+#endif
+
+    for (; row < n; ++row)
+    {
+      std::uint8_t *r = data + row * rowSize_;
+      for (const std::size_t size : sizes_)
+      {
+        swapNumber(r, size);
+        r += size;
+      }
+    }
+  }
+
+private:
+  /// Shuffle of at most 16 bytes starting at some offset in a row.
+  struct Shuffle
+  {
+    /// Offset of the shuffle in a row.
+    std::size_t offset;
+    /// Source byte index for every byte in the shuffle.
+    std::uint8_t mask[16];
+  };
+
+  /// Returns the index of the byte that ends up at index \p i, in case the
+  /// number of the given size starting at index \p start is byte swapped.
+  static std::uint8_t swappedIndex(std::size_t start, std::size_t size, std::size_t i)
+  {
+    return static_cast<std::uint8_t>(start + (size - 1 - (i - start)));
+  }
+
+  /// Byte swaps a single number of the given size in place.
+  static void swapNumber(std::uint8_t *p, std::size_t size)
+  {
+    switch (size)
+    {
+      case 2:
+        swapNumber<std::uint16_t>(p);
+        break;
+      case 4:
+        swapNumber<std::uint32_t>(p);
+        break;
+      case 8:
+        swapNumber<std::uint64_t>(p);
+        break;
+      default:
+        break;
+    }
+  }
+
+  template<typename T>
+  static void swapNumber(std::uint8_t *p)
+  {
+    T t;
+    std::memcpy(&t, p, sizeof(T));
+    t = byte_swap(t);
+    std::memcpy(p, &t, sizeof(T));
+  }
+
+#if defined(PLYWOOT_HAS_SSSE3)
+  /// Shuffles the 16 bytes starting at \p p in place using the given mask.
+  static void shuffle(std::uint8_t *p, const std::uint8_t *mask)
+  {
+    const __m128i m = _mm_loadu_si128(reinterpret_cast<const __m128i *>(mask));
+    __m128i *v = reinterpret_cast<__m128i *>(p);
+    _mm_storeu_si128(v, _mm_shuffle_epi8(_mm_loadu_si128(v), m));
+  }
+#elif defined(PLYWOOT_HAS_NEON)
+  /// Shuffles the 16 bytes starting at \p p in place using the given mask.
+  static void shuffle(std::uint8_t *p, const std::uint8_t *mask)
+  {
+    vst1q_u8(p, vqtbl1q_u8(vld1q_u8(p), vld1q_u8(mask)));
+  }
+#endif
+
+  /// Size in bytes of every number in a row.
+  std::vector<std::size_t> sizes_;
+  /// Size in bytes of a row.
+  std::size_t rowSize_{0};
+  /// Size in bytes of all numbers in case they all have the same size, zero
+  /// otherwise.
+  std::size_t numberSize_{0};
+  /// Shuffles that convert a single row, or, in case all numbers have the same
+  /// size, a single 16-byte block of numbers.
+  std::vector<Shuffle> shuffles_;
+};
+
 }
 
 #endif
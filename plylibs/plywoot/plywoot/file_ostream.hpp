@@ -0,0 +1,505 @@
+/*
+   This file is part of PLYwoot, a header-only PLY parser.
+
+   Copyright (C) 2023-2026, Ton van den Heuvel
+
+   PLYwoot is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef PLYWOOT_FILE_OSTREAM_HPP
+#define PLYWOOT_FILE_OSTREAM_HPP
+
+/// \file
+
+#include "buffered_ostream.hpp"
+#include "exceptions.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <new>
+#include <streambuf>
+#include <string>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define PLYWOOT_HAS_POSIX_FILE_IO
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#endif
+
+namespace plywoot {
+
+/// Exception thrown in case some I/O operation on a file fails.
+struct IoError : Exception
+{
+  /// Constructs an I/O error exception for the given failing operation, using
+  /// the current value of `errno` to describe the error.
+  ///
+  /// \param operation description of the operation that failed
+  IoError(const std::string &operation) : Exception("I/O error: " + operation + ": " + std::strerror(errno)) {}
+};
+
+/// Options for writing PLY data directly to a file, see
+/// `OStream::write(const char *, FileWriteOptions)`.
+struct FileWriteOptions
+{
+  /// Whether to bypass the operating system page cache (`O_DIRECT`), where
+  /// supported. This reduces CPU usage when writing large files to fast
+  /// storage, but requires all data to be staged in aligned buffers.
+  bool direct = false;
+  /// Whether to reserve disk space for the complete output file up front, in
+  /// case the size of the output can be computed before writing.
+  bool preallocate = true;
+};
+
+}
+
+#ifdef PLYWOOT_HAS_POSIX_FILE_IO
+
+namespace {
+
+/// Size of the staging buffer of a file output stream buffer; needs to be a
+/// multiple of `FileAlignment`, may need tweaking.
+constexpr std::size_t FileStagingBufferSize{4 * 1024 * 1024};
+
+/// Minimum size of a single write to a file output stream buffer for it to be
+/// passed on to the file directly instead of being staged. This is low enough
+/// for the buffers a `BufferedOStream` flushes as they fill up to bypass the
+/// staging buffer, such that formatted data is not copied twice.
+constexpr std::size_t FileDirectWriteSize{OStreamBufferSize / 2};
+
+/// Alignment of memory buffers, file offsets, and sizes when writing to files
+/// opened with `O_DIRECT`.
+constexpr std::size_t FileAlignment{4096};
+
+}
+
+namespace plywoot::detail {
+
+/// Reserves disk space for a file of the given size in bytes, without changing
+/// the size of the file. This is a hint only; failures are ignored.
+///
+/// \param fd file descriptor of the file to reserve disk space for
+/// \param size expected size of the file in bytes
+inline void preallocateFile(int fd, std::uint64_t size)
+{
+#if defined(__linux__) && defined(FALLOC_FL_KEEP_SIZE)
+  ::fallocate(fd, FALLOC_FL_KEEP_SIZE, 0, static_cast<off_t>(size));
+#else
+  (void)fd;
+  (void)size;
+#endif
+}
+
+/// Output stream buffer that writes directly to a file descriptor, bypassing
+/// the standard library file stream implementation. Small writes are staged
+/// in a large aligned buffer. Large writes are passed on to the file as is
+/// using `writev()`, together with any staged data, without copying.
+///
+/// In case the file is opened for direct I/O, all data is staged, and only
+/// aligned blocks are written until the stream buffer is closed.
+class FileOStreamBuf : public std::streambuf
+{
+public:
+  /// Opens the file at the given path for writing, truncating it in case it
+  /// exists already.
+  ///
+  /// \param path path of the file to write to
+  /// \param direct whether to bypass the page cache, where supported
+  FileOStreamBuf(const char *path, bool direct)
+  {
+    int flags = O_WRONLY | O_CREAT | O_TRUNC;
+#ifdef O_DIRECT
+    if (direct) { flags |= O_DIRECT; }
+#else
+    direct = false;
+#endif
+
+    fd_ = ::open(path, flags, 0644);
+    if (fd_ < 0 && direct)
+    {
+      // Note; not all file systems support direct I/O, fall back to regular
+      // I/O in that case.
+      direct = false;
+      fd_ = ::open(path, flags & ~O_DIRECT_FLAG, 0644);
+    }
+    if (fd_ < 0) { throw IoError{std::string{"unable to open '"} + path + "'"}; }
+
+    direct_ = direct;
+
+    void *buffer = nullptr;
+    if (::posix_memalign(&buffer, FileAlignment, FileStagingBufferSize) != 0)
+    {
+      ::close(fd_);
+      throw std::bad_alloc{};
+    }
+    buffer_ = static_cast<char *>(buffer);
+    setp(buffer_, buffer_ + FileStagingBufferSize);
+  }
+
+  /// Closes the file in case it was not closed yet, ignoring any errors; use
+  /// `close()` to be notified about errors.
+  ~FileOStreamBuf() override
+  {
+    if (fd_ >= 0)
+    {
+      try
+      {
+        close();
+      }
+      catch (...)
+      {
+      }
+    }
+    std::free(buffer_);
+  }
+
+  /// No copy semantics allowed.
+  FileOStreamBuf(const FileOStreamBuf &) = delete;
+  FileOStreamBuf &operator=(const FileOStreamBuf &) = delete;
+
+  /// Reserves disk space for a file of the given size in bytes, see
+  /// `preallocateFile()`.
+  ///
+  /// \param size expected size of the file in bytes
+  void preallocate(std::uint64_t size) { preallocateFile(fd_, size); }
+
+  /// Writes all staged data to the file, and closes it.
+  void close()
+  {
+    if (fd_ < 0) return;
+
+    try
+    {
+      if (direct_)
+      {
+        // The remaining tail is likely not a multiple of the required
+        // alignment, so write it using regular I/O.
+        writeAligned();
+        ::fcntl(fd_, F_SETFL, ::fcntl(fd_, F_GETFL) & ~O_DIRECT_FLAG);
+      }
+
+      writeAll(pbase(), static_cast<std::size_t>(pptr() - pbase()), nullptr, 0);
+      setp(buffer_, buffer_ + FileStagingBufferSize);
+    }
+    catch (...)
+    {
+      ::close(fd_);
+      fd_ = -1;
+      throw;
+    }
+
+    const int result = ::close(fd_);
+    fd_ = -1;
+    if (result != 0) { throw IoError{"unable to close file"}; }
+  }
+
+protected:
+  int_type overflow(int_type c) override
+  {
+    flushStaged();
+    if (!traits_type::eq_int_type(c, traits_type::eof()))
+    {
+      *pptr() = traits_type::to_char_type(c);
+      pbump(1);
+    }
+    return traits_type::not_eof(c);
+  }
+
+  std::streamsize xsputn(const char *s, std::streamsize count) override
+  {
+    std::size_t n = static_cast<std::size_t>(count);
+
+    // Large blocks of data are written directly from the source buffer,
+    // preceded by any data that is staged.
+    if (!direct_ && n >= FileDirectWriteSize)
+    {
+      writeAll(pbase(), static_cast<std::size_t>(pptr() - pbase()), s, n);
+      setp(buffer_, buffer_ + FileStagingBufferSize);
+      return count;
+    }
+
+    while (n > 0)
+    {
+      if (pptr() == epptr()) { flushStaged(); }
+
+      const std::size_t m = std::min(n, static_cast<std::size_t>(epptr() - pptr()));
+      std::memcpy(pptr(), s, m);
+      pbump(static_cast<int>(m));
+      s += m;
+      n -= m;
+    }
+
+    return count;
+  }
+
+  int sync() override
+  {
+    try
+    {
+      flushStaged();
+    }
+    catch (...)
+    {
+      return -1;
+    }
+    return 0;
+  }
+
+private:
+#ifdef O_DIRECT
+  static constexpr int O_DIRECT_FLAG = O_DIRECT;
+#else
+  static constexpr int O_DIRECT_FLAG = 0;
+#endif
+
+  /// Writes staged data to the file. In case of direct I/O, only writes the
+  /// largest aligned block of staged data.
+  void flushStaged()
+  {
+    if (direct_) { writeAligned(); }
+    else
+    {
+      writeAll(pbase(), static_cast<std::size_t>(pptr() - pbase()), nullptr, 0);
+      setp(buffer_, buffer_ + FileStagingBufferSize);
+    }
+  }
+
+  /// Writes the largest aligned block of staged data to the file, and moves
+  /// the remaining staged data to the start of the staging buffer.
+  void writeAligned()
+  {
+    const std::size_t staged = static_cast<std::size_t>(pptr() - pbase());
+    const std::size_t aligned = staged - staged % FileAlignment;
+    writeAll(pbase(), aligned, nullptr, 0);
+
+    std::memmove(buffer_, buffer_ + aligned, staged - aligned);
+    setp(buffer_, buffer_ + FileStagingBufferSize);
+    pbump(static_cast<int>(staged - aligned));
+  }
+
+  /// Writes the two given blocks of data to the file using a single system
+  /// call where possible, retrying until all data is written.
+  void writeAll(const char *first, std::size_t firstSize, const char *second, std::size_t secondSize)
+  {
+    iovec iov[2] = {{const_cast<char *>(first), firstSize}, {const_cast<char *>(second), secondSize}};
+    iovec *curr = iov;
+    int count = 2;
+
+    while (count > 0)
+    {
+      if (curr->iov_len == 0)
+      {
+        ++curr;
+        --count;
+        continue;
+      }
+
+      const ssize_t written = ::writev(fd_, curr, count);
+      if (written < 0)
+      {
+        if (errno == EINTR) continue;
+        throw IoError{"unable to write to file"};
+      }
+
+      std::size_t remaining = static_cast<std::size_t>(written);
+      while (count > 0 && remaining >= curr->iov_len)
+      {
+        remaining -= curr->iov_len;
+        ++curr;
+        --count;
+      }
+      if (count > 0)
+      {
+        curr->iov_base = static_cast<char *>(curr->iov_base) + remaining;
+        curr->iov_len -= remaining;
+      }
+    }
+  }
+
+  /// File descriptor of the output file.
+  int fd_{-1};
+  /// Whether the file was opened for direct I/O.
+  bool direct_{false};
+  /// Staging buffer, aligned to `FileAlignment`.
+  char *buffer_{nullptr};
+};
+
+/// File that is created with a fixed size up front, such that multiple
+/// threads can write disjoint ranges of it concurrently using
+/// `PositionedOStreamBuf` instances.
+class PresizedFile
+{
+public:
+  /// Creates the file at the given path with the given size, truncating it in
+  /// case it exists already.
+  ///
+  /// \param path path of the file to create
+  /// \param size size of the file in bytes
+  PresizedFile(const char *path, std::uint64_t size)
+  {
+    fd_ = ::open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd_ < 0) { throw IoError{std::string{"unable to open '"} + path + "'"}; }
+
+    if (::ftruncate(fd_, static_cast<off_t>(size)) != 0)
+    {
+      const IoError error{std::string{"unable to resize '"} + path + "'"};
+      ::close(fd_);
+      throw error;
+    }
+  }
+
+  /// Closes the file in case it was not closed yet, ignoring any errors.
+  ~PresizedFile()
+  {
+    if (fd_ >= 0) { ::close(fd_); }
+  }
+
+  /// No copy semantics allowed.
+  PresizedFile(const PresizedFile &) = delete;
+  PresizedFile &operator=(const PresizedFile &) = delete;
+
+  /// Returns the file descriptor of the file.
+  ///
+  /// \return the file descriptor of the file
+  int fd() const { return fd_; }
+
+  /// Closes the file.
+  void close()
+  {
+    const int result = ::close(fd_);
+    fd_ = -1;
+    if (result != 0) { throw IoError{"unable to close file"}; }
+  }
+
+private:
+  /// File descriptor of the file.
+  int fd_{-1};
+};
+
+/// Output stream buffer that writes to a file descriptor starting at a fixed
+/// offset, using positioned writes. This does not use or modify the file
+/// offset of the file descriptor, so multiple instances can write to disjoint
+/// ranges of the same file concurrently.
+class PositionedOStreamBuf : public std::streambuf
+{
+public:
+  /// Constructs an output stream buffer that writes to the given file
+  /// descriptor, starting at the given offset.
+  ///
+  /// \param fd file descriptor of the file to write to
+  /// \param offset offset in bytes in the file to start writing at
+  PositionedOStreamBuf(int fd, std::uint64_t offset)
+      : fd_{fd}, offset_{offset}, buffer_{new char[FileStagingBufferSize]}
+  {
+    setp(buffer_.get(), buffer_.get() + FileStagingBufferSize);
+  }
+
+  /// No copy semantics allowed.
+  PositionedOStreamBuf(const PositionedOStreamBuf &) = delete;
+  PositionedOStreamBuf &operator=(const PositionedOStreamBuf &) = delete;
+
+  /// Writes all staged data to the file.
+  void close() { flushStaged(); }
+
+protected:
+  int_type overflow(int_type c) override
+  {
+    flushStaged();
+    if (!traits_type::eq_int_type(c, traits_type::eof()))
+    {
+      *pptr() = traits_type::to_char_type(c);
+      pbump(1);
+    }
+    return traits_type::not_eof(c);
+  }
+
+  std::streamsize xsputn(const char *s, std::streamsize count) override
+  {
+    const std::size_t n = static_cast<std::size_t>(count);
+
+    // Large blocks of data are written directly from the source buffer.
+    if (n >= FileDirectWriteSize)
+    {
+      flushStaged();
+      writeAll(s, n);
+      return count;
+    }
+
+    if (n > static_cast<std::size_t>(epptr() - pptr())) { flushStaged(); }
+    std::memcpy(pptr(), s, n);
+    pbump(static_cast<int>(n));
+
+    return count;
+  }
+
+  int sync() override
+  {
+    try
+    {
+      flushStaged();
+    }
+    catch (...)
+    {
+      return -1;
+    }
+    return 0;
+  }
+
+private:
+  /// Writes all staged data to the file.
+  void flushStaged()
+  {
+    writeAll(pbase(), static_cast<std::size_t>(pptr() - pbase()));
+    setp(buffer_.get(), buffer_.get() + FileStagingBufferSize);
+  }
+
+  /// Writes the given block of data to the file at the current offset,
+  /// retrying until all data is written, and advances the offset.
+  void writeAll(const char *src, std::size_t n)
+  {
+    while (n > 0)
+    {
+      const ssize_t written = ::pwrite(fd_, src, n, static_cast<off_t>(offset_));
+      if (written < 0)
+      {
+        if (errno == EINTR) continue;
+        throw IoError{"unable to write to file"};
+      }
+
+      src += written;
+      n -= static_cast<std::size_t>(written);
+      offset_ += static_cast<std::uint64_t>(written);
+    }
+  }
+
+  /// File descriptor of the output file.
+  int fd_;
+  /// Offset in the file the staged data is written to.
+  std::uint64_t offset_;
+  /// Staging buffer.
+  std::unique_ptr<char[]> buffer_;
+};
+
+}
+
+#endif
+
+#endif
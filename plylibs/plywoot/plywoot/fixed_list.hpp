@@ -0,0 +1,250 @@
+/*
+   This file is part of PLYwoot, a header-only PLY parser.
+
+   Copyright (C) 2023-2026, Ton van den Heuvel
+
+   PLYwoot is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef PLYWOOT_FIXED_LIST_HPP
+#define PLYWOOT_FIXED_LIST_HPP
+
+/// \file
+
+#include "endian.hpp"
+#include "reflect.hpp"
+#include "type_traits.hpp"
+#include "types.hpp"
+
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <type_traits>
+
+namespace plywoot::detail {
+
+/// Copies `n` rows of raw binary element data starting at `src` to `dest`,
+/// where each row consists of a list size of type `SizeT` followed by exactly
+/// `N` values of type `T`, all in host byte order. The list sizes are stripped
+/// while copying, so `dest` receives `n * N` tightly packed values of type `T`.
+/// All list sizes are validated to be equal to `N`; in case any of them is
+/// not, the contents of `dest` are unspecified.
+///
+/// \param src pointer to the first row of raw binary element data
+/// \param n number of rows to copy
+/// \param dest destination buffer, able to hold `n * N` values of type `T`
+/// \return \c true in case all list sizes equal `N`, \c false otherwise
+template<typename SizeT, typename T, std::size_t N>
+bool stripListSizes(const std::uint8_t *src, std::size_t n, std::uint8_t *dest)
+{
+  constexpr std::size_t SrcRowSize = sizeof(SizeT) + N * sizeof(T);
+  constexpr std::size_t DestRowSize = N * sizeof(T);
+  const SizeT expected = static_cast<SizeT>(N);
+
+  std::size_t i = 0;
+  bool valid = true;
+
+#ifdef PLYWOOT_HAS_SSE2
+  if constexpr (SrcRowSize <= 16)
+  {
+    // Each row is loaded as a single 16-byte vector, compared against the
+    // expected list size, and shifted to drop the list size before it is
+    // stored. Loads and stores may extend into the next row; the store for the
+    // next row overwrites those bytes again. The last few rows, for which a
+    // 16-byte store would go out of bounds, are handled by the scalar loop.
+    const std::size_t numVectorRows = n * DestRowSize >= 16 ? (n * DestRowSize - 16) / DestRowSize + 1 : 0;
+
+    std::uint8_t expectedBytes[16] = {};
+    std::memcpy(expectedBytes, &expected, sizeof(SizeT));
+    const __m128i e = _mm_loadu_si128(reinterpret_cast<const __m128i *>(expectedBytes));
+
+    constexpr int SizeMask = (1 << sizeof(SizeT)) - 1;
+    int mask = SizeMask;
+    for (; i < numVectorRows; ++i)
+    {
+      const __m128i row = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + i * SrcRowSize));
+      mask &= _mm_movemask_epi8(_mm_cmpeq_epi8(row, e));
+      _mm_storeu_si128(reinterpret_cast<__m128i *>(dest + i * DestRowSize), _mm_srli_si128(row, sizeof(SizeT)));
+    }
+    valid = mask == SizeMask;
+  }
+#endif
+
+  for (; i < n; ++i)
+  {
+    SizeT size;
+    std::memcpy(&size, src + i * SrcRowSize, sizeof(SizeT));
+    valid &= size == expected;
+    std::memcpy(dest + i * DestRowSize, src + i * SrcRowSize + sizeof(SizeT), DestRowSize);
+  }
+
+  return valid;
+}
+
+/// Function type of the list size stripping functions.
+using StripListSizesFn = bool (*)(const std::uint8_t *, std::size_t, std::uint8_t *);
+
+/// @{
+/// Returns a function that copies rows of raw binary element data directly to
+/// the destination buffer, in case the element consists of a single list
+/// property that is read into a `reflect::Array<T, N>`, the list values are
+/// of type `T`, the data is in host byte order, and the array values are
+/// tightly packed in the destination buffer given its \p alignment. Returns
+/// `nullptr` in all other cases.
+///
+/// \param element element to be read
+/// \param alignment alignment of the destination type of a single row
+/// \return a function to copy rows of the element in bulk, or `nullptr`
+template<typename Endianness, typename U>
+StripListSizesFn listSizeStripper(const PlyElement &, std::size_t, reflect::Type<U>)
+{
+  return nullptr;
+}
+
+template<typename Endianness, typename T, std::size_t N>
+StripListSizesFn
+listSizeStripper(const PlyElement &element, std::size_t alignment, reflect::Type<reflect::Array<T, N>>)
+{
+  if constexpr (!std::is_same_v<Endianness, HostEndian> || !std::is_arithmetic_v<T>) { return nullptr; }
+  else
+  {
+    if (element.properties().size() != 1) return nullptr;
+
+    const PlyProperty &property = element.properties().front();
+    if (!property.isList() || !isSame<T>(property.type()) || (N * sizeof(T)) % alignment != 0) return nullptr;
+
+    return visitType(property.sizeType(), [](auto sizeType) -> StripListSizesFn {
+      using SizeT = typename decltype(sizeType)::DestT;
+      if constexpr (std::is_integral_v<SizeT> && N <= static_cast<std::size_t>(std::numeric_limits<SizeT>::max()))
+      {
+        return &stripListSizes<SizeT, T, N>;
+      }
+      else { return nullptr; }
+    });
+  }
+}
+/// @}
+
+/// Copies `n` rows of tightly packed arrays of `N` values of type `T` starting
+/// at `src` to `dest`, prepending the list size `N` of type `SizeT` to every
+/// row, such that `dest` receives `n` rows of binary PLY list data. In case
+/// `Swap` is \c true, both the list sizes and the values are converted between
+/// endian representations on the fly.
+///
+/// \param src pointer to the first array value
+/// \param n number of rows to copy
+/// \param dest destination buffer, able to hold `n` rows of binary PLY list
+///     data
+template<typename SizeT, typename T, std::size_t N, bool Swap>
+void injectListSizes(const std::uint8_t *src, std::size_t n, std::uint8_t *dest)
+{
+  constexpr std::size_t SrcRowSize = N * sizeof(T);
+  constexpr std::size_t DestRowSize = sizeof(SizeT) + N * sizeof(T);
+
+  SizeT size = static_cast<SizeT>(N);
+  if constexpr (Swap) { size = byte_swap(size); }
+
+  std::size_t i = 0;
+
+#ifdef PLYWOOT_HAS_SSE2
+  if constexpr (DestRowSize <= 16)
+  {
+    // Each row is loaded as a single 16-byte vector, optionally byte swapped,
+    // shifted to make room for the list size, and stored after inserting the
+    // list size. Loads and stores may extend into the next row; the store for
+    // the next row overwrites those bytes again. The last few rows, for which a
+    // 16-byte load would go out of bounds, are handled by the scalar loop.
+    const std::size_t numVectorRows = n * SrcRowSize >= 16 ? (n * SrcRowSize - 16) / SrcRowSize + 1 : 0;
+
+    std::uint8_t sizeBytes[16] = {};
+    std::memcpy(sizeBytes, &size, sizeof(SizeT));
+    const __m128i s = _mm_loadu_si128(reinterpret_cast<const __m128i *>(sizeBytes));
+
+    for (; i < numVectorRows; ++i)
+    {
+      __m128i row = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + i * SrcRowSize));
+      if constexpr (Swap) { row = byteSwapLanes<sizeof(T)>(row); }
+      _mm_storeu_si128(
+          reinterpret_cast<__m128i *>(dest + i * DestRowSize), _mm_or_si128(_mm_slli_si128(row, sizeof(SizeT)), s));
+    }
+  }
+#endif
+
+  for (; i < n; ++i)
+  {
+    std::uint8_t *to = dest + i * DestRowSize;
+    std::memcpy(to, &size, sizeof(SizeT));
+    to += sizeof(SizeT);
+
+    if constexpr (Swap)
+    {
+      for (std::size_t j = 0; j < N; ++j, to += sizeof(T))
+      {
+        T t;
+        std::memcpy(&t, src + i * SrcRowSize + j * sizeof(T), sizeof(T));
+        t = byte_swap(t);
+        std::memcpy(to, &t, sizeof(T));
+      }
+    }
+    else { std::memcpy(to, src + i * SrcRowSize, SrcRowSize); }
+  }
+}
+
+/// Function type of the list size injection functions.
+using InjectListSizesFn = void (*)(const std::uint8_t *, std::size_t, std::uint8_t *);
+
+/// @{
+/// Returns a function that writes rows of arrays from the source buffer
+/// directly as binary PLY list data in the given endianness, in case the
+/// element consists of a single list property that is written from a
+/// `reflect::Array<T, N>`, the list values are of type `T`, and the array
+/// values are tightly packed in the source buffer given its \p alignment.
+/// Returns `nullptr` in all other cases.
+///
+/// \param element element to be written
+/// \param alignment alignment of the source type of a single row
+/// \return a function to write rows of the element in bulk, or `nullptr`
+template<typename Endianness, typename U>
+InjectListSizesFn listSizeInjector(const PlyElement &, std::size_t, reflect::Type<U>)
+{
+  return nullptr;
+}
+
+template<typename Endianness, typename T, std::size_t N>
+InjectListSizesFn
+listSizeInjector(const PlyElement &element, std::size_t alignment, reflect::Type<reflect::Array<T, N>>)
+{
+  if constexpr (!std::is_arithmetic_v<T>) { return nullptr; }
+  else
+  {
+    if (element.properties().size() != 1) return nullptr;
+
+    const PlyProperty &property = element.properties().front();
+    if (!property.isList() || !isSame<T>(property.type()) || (N * sizeof(T)) % alignment != 0) return nullptr;
+
+    return visitType(property.sizeType(), [](auto sizeType) -> InjectListSizesFn {
+      using SizeT = typename decltype(sizeType)::DestT;
+      if constexpr (std::is_integral_v<SizeT> && N <= static_cast<std::size_t>(std::numeric_limits<SizeT>::max()))
+      {
+        return &injectListSizes<SizeT, T, N, !std::is_same_v<Endianness, HostEndian>>;
+      }
+      else { return nullptr; }
+    });
+  }
+}
+/// @}
+
+}
+
+#endif
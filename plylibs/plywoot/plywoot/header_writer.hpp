@@ -0,0 +1,101 @@
+/*
+   This file is part of PLYwoot, a header-only PLY parser.
+
+   Copyright (C) 2023-2026, Ton van den Heuvel
+
+   PLYwoot is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef PLYWOOT_HEADER_WRITER_HPP
+#define PLYWOOT_HEADER_WRITER_HPP
+
+/// \file
+
+#include "types.hpp"
+
+#include <cstdint>
+#include <ostream>
+#include <vector>
+
+namespace plywoot::detail {
+
+/// Writes the ASCII PLY header, which defines the format of the PLY data, the
+/// elements and element properties that occur in the data.
+///
+/// \param os output stream to write the PLY header data to
+/// \param format format of the PLY data following the header
+/// \param comments comments to write to the header, sorted ascending based on
+///     their associated line number
+/// \param elements elements to define in the header
+inline void writeHeader(
+    std::ostream &os,
+    PlyFormat format,
+    const std::vector<Comment> &comments,
+    const std::vector<PlyElement> &elements)
+{
+  os << "ply\n";
+
+  switch (format)
+  {
+    case PlyFormat::Ascii:
+      os << "format ascii 1.0\n";
+      break;
+    case PlyFormat::BinaryBigEndian:
+      os << "format binary_big_endian 1.0\n";
+      break;
+    case PlyFormat::BinaryLittleEndian:
+      os << "format binary_little_endian 1.0\n";
+      break;
+  }
+
+  // Maintain line number to be able to serialize comments at the right
+  // location in the header. Comments may only occur after the 'ply' magic
+  // 'number', and the format specification. Ideally this state should be
+  // limited to the scope of the closure, but that is not supported in C++11.
+  std::uint32_t line = 2;
+  auto first = comments.begin();
+  const auto last = comments.end();
+  const auto maybeWriteComments = [&]() {
+    while (first != last && first->line == line++)
+    {
+      if (first->text.empty()) { os << "comment\n"; }
+      else { os << "comment " << first->text << '\n'; }
+      ++first;
+    }
+  };
+
+  for (const PlyElement &element : elements)
+  {
+    maybeWriteComments();
+    os << "element " << element.name() << ' ' << element.size() << '\n';
+
+    for (const PlyProperty &property : element.properties())
+    {
+      maybeWriteComments();
+      if (property.isList())
+      {
+        os << "property list " << property.sizeType() << ' ' << property.type() << ' ' << property.name()
+           << '\n';
+      }
+      else { os << "property " << property.type() << ' ' << property.name() << '\n'; }
+    }
+  }
+
+  maybeWriteComments();
+  os << "end_header\n";
+}
+
+}
+
+#endif
@@ -0,0 +1,198 @@
+/*
+   This file is part of PLYwoot, a header-only PLY parser.
+
+   Copyright (C) 2023-2026, Ton van den Heuvel
+
+   PLYwoot is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef PLYWOOT_INDEX_HPP
+#define PLYWOOT_INDEX_HPP
+
+/// \file
+
+#include "exceptions.hpp"
+#include "types.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <istream>
+#include <ostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace plywoot {
+
+/// Exception thrown in case a PLY index is malformed, or does not match the
+/// PLY data it is used with.
+struct InvalidPlyIndex : Exception
+{
+  InvalidPlyIndex(const std::string &message) : Exception("invalid PLY index: " + message) {}
+};
+
+/// Index into the element data of some PLY file that allows positioning the
+/// read head at any row of any element without parsing all data preceding it,
+/// see `IStream::buildIndex()` and `IStream::seek()`. For every element, the
+/// byte offset of its first row is stored. In case all rows of an element have
+/// the same size in bytes, that size is stored as well, so the offset of every
+/// row can be calculated directly. Otherwise, the offset of every K-th row is
+/// stored as a checkpoint, and rows in between checkpoints are skipped over.
+/// All offsets are relative to the start of the element data, directly after
+/// the header.
+///
+/// An index can be stored next to the PLY file it belongs to, by convention
+/// using the `.plyidx` extension, see `save()` and `load()`.
+class PlyIndex
+{
+public:
+  /// Index of a single element.
+  struct Entry
+  {
+    /// Name of the element.
+    std::string name;
+    /// Number of rows in the element.
+    std::size_t size{0};
+    /// Offset of the first row of the element.
+    std::uint64_t offset{0};
+    /// Size in bytes of a single row in case all rows have the same size, zero
+    /// otherwise.
+    std::size_t rowSize{0};
+    /// Number of rows between two consecutive checkpoints, in case the row
+    /// size is not fixed.
+    std::size_t rowsPerCheckpoint{0};
+    /// Offsets of every `rowsPerCheckpoint`-th row, starting at the first row,
+    /// in case the row size is not fixed.
+    std::vector<std::uint64_t> checkpoints;
+  };
+
+  /// Constructs an empty index.
+  PlyIndex() = default;
+  /// Constructs an index from the given list of element indices, one for every
+  /// element in the PLY data, in order.
+  ///
+  /// \param entries element indices
+  explicit PlyIndex(std::vector<Entry> entries) : entries_{std::move(entries)} {}
+
+  /// Returns the indices of all elements.
+  ///
+  /// \return the indices of all elements, in order
+  const std::vector<Entry> &entries() const { return entries_; }
+
+  /// Returns whether this index was built for PLY data with the given list of
+  /// elements.
+  ///
+  /// \param elements all elements in some PLY data, in order
+  /// \return \c true in case this index matches the given elements, \c false
+  ///     otherwise
+  bool matches(const std::vector<PlyElement> &elements) const
+  {
+    if (elements.size() != entries_.size()) return false;
+
+    for (std::size_t i = 0; i < elements.size(); ++i)
+    {
+      if (elements[i].name() != entries_[i].name || elements[i].size() != entries_[i].size) return false;
+    }
+
+    return true;
+  }
+
+  /// Returns the row closest to, but not after the given row of the given
+  /// element, for which the offset is known, together with that offset. In
+  /// case the element has a fixed row size, that is the given row itself.
+  ///
+  /// \param element index of the element in the list of elements
+  /// \param row row in the element to look up
+  /// \return a pair of the nearest preceding row with a known offset, and its
+  ///     offset
+  std::pair<std::size_t, std::uint64_t> checkpoint(std::size_t element, std::size_t row) const
+  {
+    const Entry &entry = entries_[element];
+    if (entry.rowSize > 0 || entry.checkpoints.empty())
+    {
+      return {row, entry.offset + static_cast<std::uint64_t>(row) * entry.rowSize};
+    }
+
+    const std::size_t i = std::min(row / entry.rowsPerCheckpoint, entry.checkpoints.size() - 1);
+    return {i * entry.rowsPerCheckpoint, entry.checkpoints[i]};
+  }
+
+  /// Writes this index to the given output stream, in a simple line based
+  /// text format.
+  ///
+  /// \param os output stream to write the index to
+  void save(std::ostream &os) const
+  {
+    os << "plyidx 1\n";
+    for (const Entry &entry : entries_)
+    {
+      os << "element " << entry.name << ' ' << entry.size << ' ' << entry.offset << ' ' << entry.rowSize << ' '
+         << entry.rowsPerCheckpoint << ' ' << entry.checkpoints.size() << '\n';
+      for (const std::uint64_t checkpoint : entry.checkpoints) { os << checkpoint << '\n'; }
+    }
+  }
+
+  /// Reads an index from the given input stream, as written by `save()`.
+  ///
+  /// \param is input stream to read the index from
+  /// \return the index read from the input stream
+  /// \throws InvalidPlyIndex in case the input stream does not contain a valid
+  ///     index
+  static PlyIndex load(std::istream &is)
+  {
+    std::string token;
+    int version = 0;
+    if (!(is >> token >> version) || token != "plyidx" || version != 1)
+    {
+      throw InvalidPlyIndex{"unsupported index format"};
+    }
+
+    std::vector<Entry> entries;
+    while (is >> token)
+    {
+      if (token != "element") { throw InvalidPlyIndex{"unexpected token '" + token + "'"}; }
+
+      Entry entry;
+      std::size_t numCheckpoints = 0;
+      if (!(is >> entry.name >> entry.size >> entry.offset >> entry.rowSize >> entry.rowsPerCheckpoint >>
+            numCheckpoints))
+      {
+        throw InvalidPlyIndex{"malformed element definition"};
+      }
+
+      if (numCheckpoints > 0 && (entry.rowSize > 0 || entry.rowsPerCheckpoint == 0))
+      {
+        throw InvalidPlyIndex{"unexpected checkpoints for element '" + entry.name + "'"};
+      }
+
+      entry.checkpoints.resize(numCheckpoints);
+      for (std::uint64_t &checkpoint : entry.checkpoints)
+      {
+        if (!(is >> checkpoint)) { throw InvalidPlyIndex{"missing checkpoints for element '" + entry.name + "'"}; }
+      }
+
+      entries.push_back(std::move(entry));
+    }
+
+    return PlyIndex{std::move(entries)};
+  }
+
+private:
+  /// Indices of all elements, in order.
+  std::vector<Entry> entries_;
+};
+
+}
+
+#endif
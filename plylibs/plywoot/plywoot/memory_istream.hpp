@@ -0,0 +1,108 @@
+/*
+   This file is part of PLYwoot, a header-only PLY parser.
+
+   Copyright (C) 2023-2026, Ton van den Heuvel
+
+   PLYwoot is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef PLYWOOT_MEMORY_ISTREAM_HPP
+#define PLYWOOT_MEMORY_ISTREAM_HPP
+
+/// \file
+
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+namespace plywoot::detail {
+
+/// Input stream that reads from a block of memory that is already fully
+/// available, providing the same interface as `BufferedIStream` for the
+/// operations used by the binary parser policies. Since the complete block of
+/// data is present in memory, none of the operations need to check whether
+/// data needs to be buffered, which allows the compiler to vectorize the
+/// conversion loops. It is the responsibility of the caller to never read past
+/// the end of the memory block.
+class MemoryIStream
+{
+public:
+  /// Constructs a memory input stream reading from the range [`first`,
+  /// `last`).
+  MemoryIStream(const std::uint8_t *first, const std::uint8_t *last)
+      : c_{reinterpret_cast<const char *>(first)}, eob_{reinterpret_cast<const char *>(last)}
+  {
+  }
+
+  /// No copy semantics allowed.
+  MemoryIStream(const MemoryIStream &) = delete;
+  MemoryIStream &operator=(const MemoryIStream &) = delete;
+
+  /// Returns whether the read head is at the end of the memory block.
+  bool eof() const { return c_ == eob_; }
+
+  /// Reads an object of the given type from the memory block.
+  template<typename T>
+  inline T read()
+  {
+    T t;
+    std::memcpy(&t, c_, sizeof(T));
+    c_ += sizeof(T);
+    return t;
+  }
+
+  /// Reads `N` objects of the given type `From` from the memory block, and
+  /// stores them contiguously at the given destination in memory as numbers of
+  /// type `To`.
+  template<typename From, typename To, std::size_t N>
+  std::uint8_t *read(std::uint8_t *dest)
+  {
+    if constexpr (std::is_same_v<From, To>) { return this->memcpy(dest, N * sizeof(From)); }
+    else
+    {
+      From from[N];
+      std::memcpy(from, c_, N * sizeof(From));
+      c_ += N * sizeof(From);
+
+      To to[N];
+      for (std::size_t i = 0; i < N; ++i) { to[i] = static_cast<To>(from[i]); }
+      std::memcpy(dest, to, N * sizeof(To));
+
+      return dest + N * sizeof(To);
+    }
+  }
+
+  /// Copies `n` bytes to the given destination buffer, assuming it may hold
+  /// that many bytes. Returns a pointer pointing to one byte after the last
+  /// byte that was copied to `dest`.
+  inline std::uint8_t *memcpy(std::uint8_t *dest, std::size_t n)
+  {
+    std::memcpy(dest, c_, n);
+    c_ += n;
+    return dest + n;
+  }
+
+  /// Skips the given number of bytes in the memory block.
+  void skip(std::size_t n) { c_ += n; }
+
+private:
+  /// Character the read head is currently pointing to.
+  const char *c_;
+  /// Points to one byte past the end of the memory block.
+  const char *eob_;
+};
+
+}
+
+#endif
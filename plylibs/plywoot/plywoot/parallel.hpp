@@ -0,0 +1,109 @@
+/*
+   This file is part of PLYwoot, a header-only PLY parser.
+
+   Copyright (C) 2023-2026, Ton van den Heuvel
+
+   PLYwoot is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef PLYWOOT_PARALLEL_HPP
+#define PLYWOOT_PARALLEL_HPP
+
+/// \file
+
+#include <algorithm>
+#include <cstdint>
+#include <exception>
+#include <thread>
+#include <vector>
+
+namespace plywoot::detail {
+
+/// Returns the maximum number of worker threads to use for work that can be
+/// split up in independent tasks. In case `PLYWOOT_MAX_THREADS` is defined,
+/// that value acts as an upper bound; defining it as 1 disables all
+/// multi-threading.
+///
+/// \return the maximum number of worker threads to use
+inline std::size_t maxThreads()
+{
+  const std::size_t n = std::max(1u, std::thread::hardware_concurrency());
+#ifdef PLYWOOT_MAX_THREADS
+  return std::min<std::size_t>(n, PLYWOOT_MAX_THREADS);
+#else
+  return n;
+#endif
+}
+
+/// Splits the range [0, `n`) up in at most `numThreads` consecutive
+/// subranges, and calls `f(first, last)` for each subrange, each on its own
+/// thread. The calling thread processes the first subrange itself. In case any
+/// of the invocations of `f` throws, the first exception is rethrown after all
+/// threads finish.
+///
+/// \param n number of items to process
+/// \param numThreads maximum number of threads to use
+/// \param f function to invoke per subrange
+template<typename F>
+void parallelFor(std::size_t n, std::size_t numThreads, F f)
+{
+  numThreads = std::max<std::size_t>(1, std::min(numThreads, n));
+  if (numThreads == 1)
+  {
+    if (n > 0) f(std::size_t{0}, n);
+    return;
+  }
+
+  const std::size_t itemsPerThread = (n + numThreads - 1) / numThreads;
+
+  std::vector<std::exception_ptr> exceptions(numThreads);
+  std::vector<std::thread> threads;
+  threads.reserve(numThreads - 1);
+
+  for (std::size_t t = 1; t < numThreads; ++t)
+  {
+    const std::size_t first = std::min(n, t * itemsPerThread);
+    const std::size_t last = std::min(n, first + itemsPerThread);
+    threads.emplace_back([&f, &exceptions, t, first, last]() {
+      try
+      {
+        if (first < last) f(first, last);
+      }
+      catch (...)
+      {
+        exceptions[t] = std::current_exception();
+      }
+    });
+  }
+
+  try
+  {
+    f(std::size_t{0}, std::min(n, itemsPerThread));
+  }
+  catch (...)
+  {
+    exceptions[0] = std::current_exception();
+  }
+
+  for (std::thread &thread : threads) { thread.join(); }
+
+  for (const std::exception_ptr &e : exceptions)
+  {
+    if (e) std::rethrow_exception(e);
+  }
+}
+
+}
+
+#endif
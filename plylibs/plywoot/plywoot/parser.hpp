@@ -22,13 +22,33 @@
 
 /// \file
 
+#include "binary_parser_policy.hpp"
+#include "element_data.hpp"
+#include "fixed_list.hpp"
+#include "parallel.hpp"
 #include "reflect.hpp"
 #include "std.hpp"
 #include "type_traits.hpp"
 #include "types.hpp"
 
 #include <cstdint>
+#include <cstring>
+#include <memory>
 #include <numeric>
+#include <optional>
+#include <vector>
+
+namespace {
+
+/// Maximum number of bytes of raw binary element data that is read in one go
+/// before it is decoded in parallel; may need tweaking.
+constexpr std::size_t DecodeBlockSize{16 * 1024 * 1024};
+
+/// Minimum number of rows a single thread should decode when decoding a block
+/// of raw binary element data; may need tweaking.
+constexpr std::size_t MinRowsPerThread{64 * 1024};
+
+}
 
 namespace plywoot::detail {
 
@@ -44,15 +64,22 @@ namespace plywoot::detail {
 ///   - void skipProperty(const PlyProperty &p);
 ///   - void skipProperties(std::size_t numBytes);
 ///
-///  Only for the binary policies, the following function needs to be
+///   - std::uint64_t position();
+///   - void seek(std::uint64_t position);
+///
+///  Only for the binary policies, the following functions need to be
 ///  implemented as well:
 ///
 ///   - template<typename ...Ts> void memcpy(std::uint8_t *dest, const PLyElement &e);
+///   - void readRaw(std::uint8_t *dest, std::size_t n);
 ///
 template<typename FormatParserPolicy>
 class Parser : private FormatParserPolicy
 {
 private:
+  template<typename>
+  friend class Parser;
+
   template<typename... Ts>
   struct MaybeMemcpyable
   {
@@ -60,92 +87,42 @@ private:
                                   detail::isPacked<Ts...>() && detail::isTriviallyCopyable<Ts...>();
   };
 
+  /// Parser type that is used to decode blocks of raw binary element data that
+  /// were read from the input stream up front, or `void` in case this parser
+  /// does not support decoding data in blocks.
+  using BlockParser = std::conditional_t<
+      std::is_void_v<typename ToMemoryParserPolicy<FormatParserPolicy>::type>,
+      void,
+      Parser<typename ToMemoryParserPolicy<FormatParserPolicy>::type>>;
+
 public:
   using FormatParserPolicy::FormatParserPolicy;
+  using FormatParserPolicy::position;
+  using FormatParserPolicy::seek;
 
   /// Reads the given element from the PLY input data stream, returning all data
   /// as a memory block wrapped by an instance of `PlyElementData`. For
   /// representation of the data in the memory block, see `PlyElementData` for
   /// more details.
   ///
-  /// Note: this is not optimized for performance in any way, but is meant to
-  /// provide a way to read all data from a PLY file without the need for up
-  /// front knowledge about the data a PLY file may contain. For now, it is only
-  /// used by `plywoot::convert()` to be able to convert PLY data between
-  /// different formats.
-  PlyElementData read(const PlyElement &element) const
+  /// Note: this is meant to provide a way to read all data from a PLY file
+  /// without the need for up front knowledge about the data a PLY file may
+  /// contain, for example by `plywoot::convert()` to be able to convert PLY
+  /// data between different formats. To avoid type dispatching for every
+  /// property of every row, the element properties are compiled once into a
+  /// list of read operations, see `compile()`.
+  PlyElementData read(const PlyElement &element, PlyListStorage listStorage = PlyListStorage::Vector) const
   {
-    PlyElementData result(element);
+    PlyElementData result(element, listStorage);
+    std::vector<std::uint8_t> *listArena =
+        listStorage == PlyListStorage::Arena ? &result.listArena_ : nullptr;
+
+    const std::vector<ReadOp> program = compile(element, listStorage);
 
     std::uint8_t *dest = result.data();
     for (std::size_t i = 0; i < element.size(); ++i)
     {
-      for (const PlyProperty &property : element.properties())
-      {
-        // In case of a list property, allocate a vector of the right type, and
-        // read the variable length list.
-        if (property.isList())
-        {
-          switch (property.type())
-          {
-            case PlyDataType::Char:
-              dest = readProperty(dest, property, reflect::Type<std::vector<char>>{});
-              break;
-            case PlyDataType::UChar:
-              dest = readProperty(dest, property, reflect::Type<std::vector<unsigned char>>{});
-              break;
-            case PlyDataType::Short:
-              dest = readProperty(dest, property, reflect::Type<std::vector<short>>{});
-              break;
-            case PlyDataType::UShort:
-              dest = readProperty(dest, property, reflect::Type<std::vector<unsigned short>>{});
-              break;
-            case PlyDataType::Int:
-              dest = readProperty(dest, property, reflect::Type<std::vector<int>>{});
-              break;
-            case PlyDataType::UInt:
-              dest = readProperty(dest, property, reflect::Type<std::vector<unsigned int>>{});
-              break;
-            case PlyDataType::Float:
-              dest = readProperty(dest, property, reflect::Type<std::vector<float>>{});
-              break;
-            case PlyDataType::Double:
-              dest = readProperty(dest, property, reflect::Type<std::vector<double>>{});
-              break;
-          }
-        }
-        else
-        {
-          switch (property.type())
-          {
-            case PlyDataType::Char:
-              dest = readProperty(dest, property, reflect::Type<char>{});
-              break;
-            case PlyDataType::UChar:
-              dest = readProperty(dest, property, reflect::Type<unsigned char>{});
-              break;
-            case PlyDataType::Short:
-              dest = readProperty(dest, property, reflect::Type<short>{});
-              break;
-            case PlyDataType::UShort:
-              dest = readProperty(dest, property, reflect::Type<unsigned short>{});
-              break;
-            case PlyDataType::Int:
-              dest = readProperty(dest, property, reflect::Type<int>{});
-              break;
-            case PlyDataType::UInt:
-              dest = readProperty(dest, property, reflect::Type<unsigned int>{});
-              break;
-            case PlyDataType::Float:
-              dest = readProperty(dest, property, reflect::Type<float>{});
-              break;
-            case PlyDataType::Double:
-              dest = readProperty(dest, property, reflect::Type<double>{});
-              break;
-          }
-        }
-      }
-
+      for (const ReadOp op : program) { dest = (this->*op)(dest, listArena); }
       dest = detail::align(dest, result.alignment());
     }
 
@@ -178,14 +155,183 @@ public:
       }
     }
 
+    // In case the size of a row in the binary input data is known up front,
+    // the element data can be read in large blocks that are decoded in
+    // parallel, directly into the destination buffer.
+    if constexpr (!std::is_void_v<BlockParser>)
+    {
+      const std::optional<std::size_t> rowSize =
+          detail::fixedRowSize<Ts...>(element.properties().begin(), element.properties().end());
+      if (rowSize && *rowSize > 0)
+      {
+        readBlocks<Ts...>(element, *rowSize, dest, alignment);
+        return;
+      }
+    }
+
     readElements<Ts...>(element, dest, alignment);
   }
 
   void skip(const PlyElement &element) const { this->skipElement(element); }
 
 private:
+  /// Operation that reads one or more properties of a single row of some
+  /// element into the destination buffer of a `PlyElementData` instance, see
+  /// `compile()`. The list arena is null in case lists are stored as vectors.
+  using ReadOp = std::uint8_t *(Parser::*)(std::uint8_t *dest, std::vector<std::uint8_t> *listArena) const;
+
+  /// Maximum number of consecutive scalar properties of the same type that are
+  /// fused into a single read operation.
+  static constexpr std::ptrdiff_t MaxFusedProperties{4};
+
+  /// Compiles the properties of the given element into a list of read
+  /// operations, which read a single row of the element when invoked in order.
+  /// All PLY data types are resolved up front; runs of consecutive scalar
+  /// properties of the same type (for example, the x, y, and z coordinates of
+  /// a vertex) are fused into a single read operation.
+  std::vector<ReadOp> compile(const PlyElement &element, PlyListStorage listStorage) const
+  {
+    std::vector<ReadOp> program;
+
+    const std::vector<PlyProperty> &properties = element.properties();
+    for (auto first = properties.begin(); first != properties.end();)
+    {
+      if (first->isList())
+      {
+        program.push_back(detail::visitType(first->type(), [&](auto type) {
+          using T = typename decltype(type)::DestT;
+          return detail::visitType(first->sizeType(), [&](auto sizeType) -> ReadOp {
+            using SizeT = typename decltype(sizeType)::DestT;
+            return listStorage == PlyListStorage::Arena ? &Parser::readArenaListOp<T, SizeT>
+                                                        : &Parser::readVectorListOp<T, SizeT>;
+          });
+        }));
+        ++first;
+      }
+      else
+      {
+        auto last = first + 1;
+        while (last != properties.end() && last - first < MaxFusedProperties && !last->isList() &&
+               last->type() == first->type())
+        {
+          ++last;
+        }
+
+        program.push_back(detail::visitType(first->type(), [n = last - first](auto type) -> ReadOp {
+          using T = typename decltype(type)::DestT;
+          switch (n)
+          {
+            case 1:
+              return &Parser::readNumbersOp<T, 1>;
+            case 2:
+              return &Parser::readNumbersOp<T, 2>;
+            case 3:
+              return &Parser::readNumbersOp<T, 3>;
+          }
+          return &Parser::readNumbersOp<T, 4>;
+        }));
+        first = last;
+      }
+    }
+
+    return program;
+  }
+
+  /// Read operation for `N` consecutive scalar properties of type `T`.
+  template<typename T, std::size_t N>
+  std::uint8_t *readNumbersOp(std::uint8_t *dest, std::vector<std::uint8_t> *) const
+  {
+    dest = static_cast<std::uint8_t *>(detail::align(dest, alignof(T)));
+    return this->template readNumbers<T, T, N>(dest);
+  }
+
+  /// Read operation for a list property of type `T`, stored in a vector.
+  template<typename T, typename SizeT>
+  std::uint8_t *readVectorListOp(std::uint8_t *dest, std::vector<std::uint8_t> *) const
+  {
+    return readListProperty<T, SizeT>(dest, reflect::Type<std::vector<T>>{});
+  }
+
+  /// Read operation for a list property of type `T`, stored in a list arena.
+  template<typename T, typename SizeT>
+  std::uint8_t *readArenaListOp(std::uint8_t *dest, std::vector<std::uint8_t> *listArena) const
+  {
+    return readListProperty<T, SizeT>(dest, ArenaList<T, std::vector<std::uint8_t> *>{listArena});
+  }
+
+  /// Reads the given element by reading blocks of raw binary element data
+  /// from the input stream, and decoding these blocks in parallel. This
+  /// requires the number of bytes \p rowSize of each row in the input stream
+  /// to be known up front.
+  template<typename... Ts>
+  void readBlocks(const PlyElement &element, std::size_t rowSize, std::uint8_t *dest, std::size_t alignment)
+      const
+  {
+    if (element.size() == 0) return;
+
+    const std::size_t rowsPerBlock = std::max<std::size_t>(1, DecodeBlockSize / rowSize);
+    const std::unique_ptr<std::uint8_t[]> block{
+        new std::uint8_t[std::min(element.size(), rowsPerBlock) * rowSize]};
+
+    // Number of bytes a single row occupies in the destination buffer; only
+    // known after decoding the first row.
+    std::size_t destStride = 0;
+
+    // Blocks are decoded in host byte order; in case the input data is in the
+    // other byte order, every block is converted in place first.
+    constexpr bool Swap = !std::is_same_v<typename FormatParserPolicy::EndiannessType, HostEndian>;
+    const std::optional<ByteSwapRows> byteSwapRows =
+        Swap ? std::make_optional<ByteSwapRows>(
+                   detail::fixedRowNumberSizes<Ts...>(element.properties().begin(), element.properties().end()))
+             : std::nullopt;
+
+    // Elements consisting of a single fixed size list (typically triangle
+    // faces) can be copied in bulk, stripping the list sizes on the fly.
+    StripListSizesFn stripListSizes = nullptr;
+    if constexpr (sizeof...(Ts) == 1)
+    {
+      stripListSizes = detail::listSizeStripper<HostEndian>(element, alignment, reflect::Type<Ts>{}...);
+    }
+
+    for (std::size_t row = 0; row < element.size();)
+    {
+      const std::size_t numRows = std::min(rowsPerBlock, element.size() - row);
+      this->readRaw(block.get(), numRows * rowSize);
+
+      std::size_t first = 0;
+      if (destStride == 0)
+      {
+        if (byteSwapRows) { (*byteSwapRows)(block.get(), 1); }
+
+        const BlockParser parser{block.get(), block.get() + rowSize};
+        destStride = parser.template readElements<Ts...>(
+                         PlyElement{element.name(), 1, element.properties()}, dest, alignment) -
+                     dest;
+        first = 1;
+      }
+
+      const std::uint8_t *src = block.get() + first * rowSize;
+      std::uint8_t *to = dest + (row + first) * destStride;
+      detail::parallelFor(
+          numRows - first, std::min(detail::maxThreads(), (numRows - first) / MinRowsPerThread + 1),
+          [&](std::size_t i, std::size_t j) {
+            if (byteSwapRows) { (*byteSwapRows)(block.get() + (first + i) * rowSize, j - i); }
+
+            // Note; in case some list has an unexpected size, fall back to
+            // regular decoding, which reports the offending list size.
+            if (stripListSizes && stripListSizes(src + i * rowSize, j - i, to + i * destStride)) return;
+
+            const BlockParser parser{src + i * rowSize, src + j * rowSize};
+            parser.template readElements<Ts...>(
+                PlyElement{element.name(), j - i, element.properties()}, to + i * destStride, alignment);
+          });
+
+      row += numRows;
+    }
+  }
+
   template<typename... Ts>
-  void readElements(const PlyElement &element, std::uint8_t *dest, std::size_t alignment) const
+  std::uint8_t *readElements(const PlyElement &element, std::uint8_t *dest, std::size_t alignment) const
   {
     const PlyPropertyConstIterator first = element.properties().begin();
     const PlyPropertyConstIterator last = element.properties().end();
@@ -232,6 +378,8 @@ private:
         dest = detail::align(readElement<Ts...>(dest, first, last), alignment);
       }
     }
+
+    return dest;
   }
 
   template<typename T>
@@ -254,21 +402,46 @@ private:
     dest = static_cast<std::uint8_t *>(detail::align(dest, alignof(std::vector<DestT>)));
     std::vector<DestT> &v = *reinterpret_cast<std::vector<DestT> *>(dest);
 
+    // Note; the destination vector may be reused, for example when reading an
+    // element in chunks, so make sure to discard any previous contents.
     const PlySizeT size = this->template readNumber<PlySizeT>();
+    v.clear();
     v.reserve(static_cast<std::size_t>(size));
     for (PlySizeT i = 0; i < size; ++i) { v.push_back(static_cast<DestT>(this->template readNumber<PlyT>())); }
 
     return dest + sizeof(std::vector<DestT>);
   }
 
+  template<typename PlyT, typename PlySizeT, typename DestT>
+  std::uint8_t *readListProperty(std::uint8_t *dest, ArenaList<DestT, std::vector<std::uint8_t> *> tag) const
+  {
+    dest = static_cast<std::uint8_t *>(detail::align(dest, alignof(PlyListRef)));
+
+    const PlySizeT size = this->template readNumber<PlySizeT>();
+    const std::size_t n = static_cast<std::size_t>(size);
+
+    std::vector<std::uint8_t> &arena = *tag.arena;
+    const std::size_t offset = detail::align(arena.size(), alignof(DestT));
+    arena.resize(offset + n * sizeof(DestT));
+    for (std::size_t i = 0; i < n; ++i)
+    {
+      const DestT value = static_cast<DestT>(this->template readNumber<PlyT>());
+      std::memcpy(arena.data() + offset + i * sizeof(DestT), &value, sizeof(DestT));
+    }
+
+    const PlyListRef ref{offset, n};
+    std::memcpy(dest, &ref, sizeof(PlyListRef));
+    return dest + sizeof(PlyListRef);
+  }
+
   template<typename PlyT, typename PlySizeT, typename DestT, std::size_t N>
   std::uint8_t *readListProperty(std::uint8_t *dest, reflect::Type<reflect::Array<DestT, N>>) const
   {
     static_assert(std::is_arithmetic<PlyT>::value, "unexpected PLY data type");
 
-    // TODO(ton): skip the number that defines the list in the PLY data, we
-    // expect it to be of length N; throw an exception here in case they do no match?
-    this->template skipNumber<PlySizeT>();
+    const PlySizeT size = this->template readNumber<PlySizeT>();
+    if (size != static_cast<PlySizeT>(N)) { throw InvalidListSize{N, static_cast<long long>(size)}; }
+
     dest = static_cast<std::uint8_t *>(detail::align(dest, alignof(DestT)));
     return this->template readNumbers<PlyT, DestT, N>(dest);
   }
@@ -37,9 +37,9 @@ class ParserVariant
 public:
   ParserVariant(std::istream &is, PlyFormat format) : variant_{makeVariant(is, format)} {}
 
-  PlyElementData read(const PlyElement &element) const
+  PlyElementData read(const PlyElement &element, PlyListStorage listStorage = PlyListStorage::Vector) const
   {
-    return std::visit([&](auto &&parser) { return parser.read(element); }, variant_);
+    return std::visit([&](auto &&parser) { return parser.read(element, listStorage); }, variant_);
   }
 
   template<typename Layout>
@@ -53,6 +53,16 @@ public:
     std::visit([&element](auto &&parser) { parser.skip(element); }, variant_);
   }
 
+  std::uint64_t position() const
+  {
+    return std::visit([](auto &&parser) { return parser.position(); }, variant_);
+  }
+
+  void seek(std::uint64_t position) const
+  {
+    std::visit([position](auto &&parser) { parser.seek(position); }, variant_);
+  }
+
 private:
   using Variant = std::variant<
       detail::Parser<detail::AsciiParserPolicy>,
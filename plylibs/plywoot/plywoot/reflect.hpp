@@ -105,10 +105,25 @@ public:
   Layout(const std::vector<T> &v)
       : cdata_{reinterpret_cast<const std::uint8_t *>(v.data())},
         size_{v.size()},
-        alignment_{alignof(T)}
+        alignment_{alignof(T)},
+        stride_{sizeof(T)}
   {
   }
 
+  /// Returns a layout representing the range of elements [`first`, `last`) of
+  /// this layout.
+  ///
+  /// \param first index of the first element in the range
+  /// \param last index of the element after the last element in the range
+  /// \return a layout representing the given range of elements
+  Layout slice(std::size_t first, std::size_t last) const
+  {
+    Layout result{*this};
+    result.cdata_ += first * stride_;
+    result.size_ = last - first;
+    return result;
+  }
+
   /// Returns a pointer to the read-only memory area storing instances of type
   /// `T` associated with this layout.
   ///
@@ -138,6 +153,9 @@ private:
   /// Alignment requirements of the structure instances stored in this memory
   /// block.
   std::size_t alignment_{0};
+  /// Distance in bytes between two consecutive structure instances in this
+  /// memory block.
+  std::size_t stride_{0};
 };
 
 }
@@ -27,7 +27,10 @@
 #include "types.hpp"
 
 #include <algorithm>
+#include <numeric>
+#include <optional>
 #include <type_traits>
+#include <vector>
 
 namespace plywoot::detail {
 
@@ -271,6 +274,40 @@ constexpr Ptr align(Ptr ptr, PlyDataType type)
   return ptr;
 }
 
+/// Invokes \p f with an instance of `reflect::Type<T>`, where `T` is the
+/// native type corresponding to the given PLY data type, and returns the
+/// result. This allows resolving a PLY data type to a native type once, for
+/// example to select an instantiation of some function template.
+///
+/// \param type PLY data type to resolve to a native type
+/// \param f function to invoke with the type tag of the native type
+/// \return the result of invoking \p f
+template<typename F>
+decltype(auto) visitType(PlyDataType type, F &&f)
+{
+  switch (type)
+  {
+    case PlyDataType::Char:
+      return f(reflect::Type<char>{});
+    case PlyDataType::UChar:
+      return f(reflect::Type<unsigned char>{});
+    case PlyDataType::Short:
+      return f(reflect::Type<short>{});
+    case PlyDataType::UShort:
+      return f(reflect::Type<unsigned short>{});
+    case PlyDataType::Int:
+      return f(reflect::Type<int>{});
+    case PlyDataType::UInt:
+      return f(reflect::Type<unsigned int>{});
+    case PlyDataType::Float:
+      return f(reflect::Type<float>{});
+    case PlyDataType::Double:
+      break;
+  }
+
+  return f(reflect::Type<double>{});
+}
+
 /// Type function that returns whether a type is aligned in memory at the given
 /// memory \p offset.
 ///
@@ -373,6 +410,174 @@ bool isMemcpyable(const PlyPropertyConstIterator first, const PlyPropertyConstIt
   return IsMemcpyable<T>{}(first, last) && isMemcpyable<U, Ts...>(first + detail::numProperties<T>(), last);
 }
 
+
+/// @{
+/// Type that provides a function operator that returns the number of bytes in
+/// the binary PLY input data that are consumed when parsing the range of
+/// properties in [`first`, `last`) into the given destination type `T`. In
+/// case this can not be determined up front, for example since `T` maps to a
+/// variable length list, returns `std::nullopt`. In case the number of bytes
+/// can be determined up front, `numberSizes()` appends the sizes of the
+/// individual numbers making up those bytes, in order.
+template<typename T>
+struct FixedSize
+{
+  std::optional<std::size_t> operator()(const PlyPropertyConstIterator first, const PlyPropertyConstIterator last)
+      const
+  {
+    if (first >= last) { return std::size_t{0}; }
+    if (first->isList()) { return std::nullopt; }
+    return sizeOf(first->type());
+  }
+
+  void numberSizes(
+      const PlyPropertyConstIterator first,
+      const PlyPropertyConstIterator last,
+      std::vector<std::size_t> &sizes) const
+  {
+    if (first < last) { sizes.push_back(sizeOf(first->type())); }
+  }
+};
+
+template<typename T>
+struct FixedSize<reflect::Stride<T>>
+{
+  std::optional<std::size_t> operator()(const PlyPropertyConstIterator, const PlyPropertyConstIterator) const
+  {
+    return std::size_t{0};
+  }
+
+  void numberSizes(const PlyPropertyConstIterator, const PlyPropertyConstIterator, std::vector<std::size_t> &) const
+  {
+  }
+};
+
+template<typename T>
+struct FixedSize<std::vector<T>>
+{
+  std::optional<std::size_t> operator()(const PlyPropertyConstIterator first, const PlyPropertyConstIterator last)
+      const
+  {
+    if (first >= last) { return std::size_t{0}; }
+    return std::nullopt;
+  }
+
+  void numberSizes(const PlyPropertyConstIterator, const PlyPropertyConstIterator, std::vector<std::size_t> &) const
+  {
+  }
+};
+
+template<typename T, std::size_t N>
+struct FixedSize<reflect::Pack<T, N>>
+{
+  std::optional<std::size_t> operator()(const PlyPropertyConstIterator first, const PlyPropertyConstIterator last)
+      const
+  {
+    // Note; a pack is parsed in one go using the type of the first property in
+    // the pack.
+    if (first >= last) { return std::size_t{0}; }
+    if (first->isList()) { return std::nullopt; }
+    return N * sizeOf(first->type());
+  }
+
+  void numberSizes(
+      const PlyPropertyConstIterator first,
+      const PlyPropertyConstIterator last,
+      std::vector<std::size_t> &sizes) const
+  {
+    if (first < last) { sizes.insert(sizes.end(), N, sizeOf(first->type())); }
+  }
+};
+
+template<typename T, std::size_t N>
+struct FixedSize<reflect::Array<T, N>>
+{
+  std::optional<std::size_t> operator()(const PlyPropertyConstIterator first, const PlyPropertyConstIterator last)
+      const
+  {
+    // Note; an array is expected to always store exactly N elements, so the
+    // size in bytes of the list can be calculated up front.
+    if (first >= last) { return std::size_t{0}; }
+    return sizeOf(first->sizeType()) + N * sizeOf(first->type());
+  }
+
+  void numberSizes(
+      const PlyPropertyConstIterator first,
+      const PlyPropertyConstIterator last,
+      std::vector<std::size_t> &sizes) const
+  {
+    if (first < last)
+    {
+      sizes.push_back(sizeOf(first->sizeType()));
+      sizes.insert(sizes.end(), N, sizeOf(first->type()));
+    }
+  }
+};
+/// @}
+
+/// Returns the number of bytes of a single row of binary PLY data for the
+/// element with properties in the range [`first`, `last`), when parsing it
+/// into the given list of types `Ts...`. In case the size of a row can not be
+/// determined up front, for example because one of the properties is a
+/// variable length list, returns `std::nullopt`. Properties that are not
+/// mapped on any type in `Ts...` are skipped, and are taken into account as
+/// well.
+///
+/// \param first iterator pointing to the first property in the range of input
+///     PLY properties
+/// \param last iterator pointing after the last property in the range of input
+///     PLY properties
+/// \return the size in bytes of a row of binary PLY data in case it can be
+///     computed up front, `std::nullopt` otherwise
+template<typename... Ts>
+std::optional<std::size_t> fixedRowSize(PlyPropertyConstIterator first, const PlyPropertyConstIterator last)
+{
+  std::optional<std::size_t> result{0};
+
+  // Note; `first` may advance beyond `last` in case a pack spans more
+  // properties than are defined for the element.
+  [[maybe_unused]] const auto accumulate = [&](std::optional<std::size_t> size, std::ptrdiff_t numProperties) {
+    if (result && size) { *result += *size; }
+    else { result = std::nullopt; }
+    first = numProperties < last - first ? first + numProperties : last;
+  };
+  (accumulate(FixedSize<Ts>{}(first, last), detail::numProperties<Ts>()), ...);
+
+  for (; result && first < last; ++first)
+  {
+    if (first->isList()) { result = std::nullopt; }
+    else { *result += sizeOf(first->type()); }
+  }
+
+  return result;
+}
+
+/// Returns the sizes in bytes of all individual numbers in a single row of
+/// binary PLY data for the element with properties in the range [`first`,
+/// `last`), when parsing it into the given list of types `Ts...`, in order.
+/// This assumes the size of a row is fixed, see `fixedRowSize()`.
+///
+/// \param first iterator pointing to the first property in the range of input
+///     PLY properties
+/// \param last iterator pointing after the last property in the range of input
+///     PLY properties
+/// \return the sizes in bytes of all numbers in a row of binary PLY data
+template<typename... Ts>
+std::vector<std::size_t> fixedRowNumberSizes(PlyPropertyConstIterator first, const PlyPropertyConstIterator last)
+{
+  std::vector<std::size_t> result;
+
+  [[maybe_unused]] const auto append = [&](auto fixedSize, std::ptrdiff_t numProperties) {
+    fixedSize.numberSizes(first, last, result);
+    first = numProperties < last - first ? first + numProperties : last;
+  };
+  (append(FixedSize<Ts>{}, detail::numProperties<Ts>()), ...);
+
+  for (; first < last; ++first) { result.push_back(sizeOf(first->type())); }
+
+  return result;
+}
+
 }
 
 #endif
@@ -22,12 +22,17 @@
 
 /// \file
 
+#include "binary_writer_policy.hpp"
+#include "element_data.hpp"
+#include "fixed_list.hpp"
 #include "reflect.hpp"
 #include "std.hpp"
 #include "types.hpp"
 
 #include <cstdint>
+#include <cstring>
 #include <type_traits>
+#include <vector>
 
 namespace plywoot::detail {
 
@@ -43,89 +48,70 @@ namespace plywoot::detail {
 ///
 ///   - void writeNewline();
 ///   - void writeTokenSeparator();
+///   - void flush();
+///
+///  Only for the binary policies, the following function needs to be
+///  implemented as well:
+///
+///   - void writeRaw(const std::uint8_t *src, std::size_t n);
+///   - template<typename Transform> void writeRows(const std::uint8_t *src,
+///       std::size_t n, std::size_t srcRowSize, std::size_t destRowSize,
+///       Transform transform);
 template<typename FormatWriterPolicy>
 class Writer : private FormatWriterPolicy
 {
+private:
+  /// Returns whether elements with the given layout may be written with a
+  /// single `memcpy`, that is, if the writer outputs binary data in host byte
+  /// order, and the layout types are consecutive in memory without any padding.
+  template<typename... Ts>
+  struct MaybeMemcpyable
+  {
+    static constexpr bool value = std::is_same_v<FormatWriterPolicy, BinaryWriterPolicy<HostEndian>> &&
+                                  detail::isPacked<Ts...>() && detail::isTriviallyCopyable<Ts...>();
+  };
+
+  /// Returns whether elements with the given layout may be written with a
+  /// `memcpy` followed by an in place byte swap, that is, if the writer outputs
+  /// binary data in the byte order opposite to the host byte order, and the
+  /// layout types are consecutive in memory without any padding.
+  template<typename... Ts>
+  struct MaybeSwappable
+  {
+    using SwappedEndian = std::conditional_t<std::is_same_v<HostEndian, LittleEndian>, BigEndian, LittleEndian>;
+
+    static constexpr bool value = std::is_same_v<FormatWriterPolicy, BinaryWriterPolicy<SwappedEndian>> &&
+                                  detail::isPacked<Ts...>() && detail::isTriviallyCopyable<Ts...>();
+  };
+
 public:
   using FormatWriterPolicy::FormatWriterPolicy;
+  using FormatWriterPolicy::flush;
 
   /// Writes a PLY element to the associated output stream, assuming property
   /// types should be mapped directly to their corresponding native types. This
-  /// is used for writing `PlyElementData` instances.
-  void write(const PlyElement &element, const std::uint8_t *src, std::size_t alignment) const
+  /// is used for writing `PlyElementData` instances. In case \p listArena is
+  /// not null, variable length lists are expected to be stored as
+  /// `PlyListRef` instances referring to values in the given list arena,
+  /// otherwise they are expected to be stored as `std::vector` instances.
+  ///
+  /// To avoid type dispatching for every property of every row, the element
+  /// properties are compiled once into a list of write operations, see
+  /// `compile()`.
+  void write(
+      const PlyElement &element,
+      const std::uint8_t *src,
+      std::size_t alignment,
+      const std::uint8_t *listArena = nullptr) const
   {
+    const std::vector<WriteOp> program = compile(element, listArena != nullptr);
+
     for (std::size_t i = 0; i < element.size(); ++i)
     {
-      const std::vector<PlyProperty> &properties = element.properties();
-      const auto first = properties.begin();
-      const auto last = properties.end();
-
-      auto curr = first;
-      while (curr < last)
+      for (auto op = program.begin(); op != program.end(); ++op)
       {
-        if (curr > first) { this->writeTokenSeparator(); }
-
-        const PlyProperty &property = *curr++;
-        if (property.isList())
-        {
-          switch (property.type())
-          {
-            case PlyDataType::Char:
-              src = writeProperty(src, property, reflect::Type<std::vector<char>>{});
-              break;
-            case PlyDataType::UChar:
-              src = writeProperty(src, property, reflect::Type<std::vector<unsigned char>>{});
-              break;
-            case PlyDataType::Short:
-              src = writeProperty(src, property, reflect::Type<std::vector<short>>{});
-              break;
-            case PlyDataType::UShort:
-              src = writeProperty(src, property, reflect::Type<std::vector<unsigned short>>{});
-              break;
-            case PlyDataType::Int:
-              src = writeProperty(src, property, reflect::Type<std::vector<int>>{});
-              break;
-            case PlyDataType::UInt:
-              src = writeProperty(src, property, reflect::Type<std::vector<unsigned int>>{});
-              break;
-            case PlyDataType::Float:
-              src = writeProperty(src, property, reflect::Type<std::vector<float>>{});
-              break;
-            case PlyDataType::Double:
-              src = writeProperty(src, property, reflect::Type<std::vector<double>>{});
-              break;
-          }
-        }
-        else
-        {
-          switch (property.type())
-          {
-            case PlyDataType::Char:
-              src = writeProperty(src, property, reflect::Type<char>{});
-              break;
-            case PlyDataType::UChar:
-              src = writeProperty(src, property, reflect::Type<unsigned char>{});
-              break;
-            case PlyDataType::Short:
-              src = writeProperty(src, property, reflect::Type<short>{});
-              break;
-            case PlyDataType::UShort:
-              src = writeProperty(src, property, reflect::Type<unsigned short>{});
-              break;
-            case PlyDataType::Int:
-              src = writeProperty(src, property, reflect::Type<int>{});
-              break;
-            case PlyDataType::UInt:
-              src = writeProperty(src, property, reflect::Type<unsigned int>{});
-              break;
-            case PlyDataType::Float:
-              src = writeProperty(src, property, reflect::Type<float>{});
-              break;
-            case PlyDataType::Double:
-              src = writeProperty(src, property, reflect::Type<double>{});
-              break;
-          }
-        }
+        if (op != program.begin()) { this->writeTokenSeparator(); }
+        src = (this->**op)(src, listArena);
       }
 
       src = detail::align(src, alignment);
@@ -140,6 +126,51 @@ public:
     const auto first = element.properties().begin();
     const auto last = element.properties().end();
 
+    // In case the in-memory representation of the layout is byte-identical to
+    // the binary representation of the element, write all element data in one
+    // go.
+    if constexpr (MaybeMemcpyable<Ts...>::value)
+    {
+      if (detail::sizeOf<Ts...>() % layout.alignment() == 0 && detail::isMemcpyable<Ts...>(first, last))
+      {
+        this->writeRaw(layout.data(), layout.size() * detail::sizeOf<Ts...>());
+        return;
+      }
+    }
+
+    // Same as above, but for the opposite byte order; element data is copied
+    // in large blocks into the output buffer, and byte swapped in place.
+    if constexpr (MaybeSwappable<Ts...>::value)
+    {
+      if (detail::sizeOf<Ts...>() % layout.alignment() == 0 && detail::isMemcpyable<Ts...>(first, last))
+      {
+        const ByteSwapRows byteSwapRows{detail::fixedRowNumberSizes<Ts...>(first, last)};
+        constexpr std::size_t RowSize = detail::sizeOf<Ts...>();
+        this->writeRows(
+            layout.data(), layout.size(), RowSize, RowSize,
+            [&](const std::uint8_t *src, std::size_t n, std::uint8_t *dest) {
+              std::memcpy(dest, src, n * RowSize);
+              byteSwapRows(dest, n);
+            });
+        return;
+      }
+    }
+
+    // Elements consisting of a single fixed size list (typically triangle
+    // faces) can be written in bulk, injecting the list sizes on the fly.
+    if constexpr (!std::is_same_v<FormatWriterPolicy, AsciiWriterPolicy> && sizeof...(Ts) == 1)
+    {
+      if (const InjectListSizesFn injectListSizes =
+              detail::listSizeInjector<typename FormatWriterPolicy::EndiannessType>(
+                  element, layout.alignment(), reflect::Type<Ts>{}...))
+      {
+        this->writeRows(
+            layout.data(), layout.size(), detail::sizeOf<Ts...>(), *detail::fixedRowSize<Ts...>(first, last),
+            injectListSizes);
+        return;
+      }
+    }
+
     const std::uint8_t *src = layout.data();
     for (std::size_t i = 0; i < layout.size(); ++i)
     {
@@ -148,6 +179,89 @@ public:
   }
 
 private:
+  /// Operation that writes one or more properties of a single row of some
+  /// element from the source buffer of a `PlyElementData` instance, see
+  /// `compile()`. The list arena is null in case lists are stored as vectors.
+  using WriteOp = const std::uint8_t *(Writer::*)(const std::uint8_t *src, const std::uint8_t *listArena) const;
+
+  /// Maximum number of consecutive scalar properties of the same type that are
+  /// fused into a single write operation.
+  static constexpr std::ptrdiff_t MaxFusedProperties{4};
+
+  /// Compiles the properties of the given element into a list of write
+  /// operations, which write a single row of the element when invoked in
+  /// order, separated by token separators. All PLY data types are resolved up
+  /// front; runs of consecutive scalar properties of the same type are fused
+  /// into a single write operation.
+  std::vector<WriteOp> compile(const PlyElement &element, bool useListArena) const
+  {
+    std::vector<WriteOp> program;
+
+    const std::vector<PlyProperty> &properties = element.properties();
+    for (auto first = properties.begin(); first != properties.end();)
+    {
+      if (first->isList())
+      {
+        program.push_back(detail::visitType(first->type(), [&](auto type) {
+          using T = typename decltype(type)::DestT;
+          return detail::visitType(first->sizeType(), [&](auto sizeType) -> WriteOp {
+            using SizeT = typename decltype(sizeType)::DestT;
+            return useListArena ? &Writer::writeArenaListOp<T, SizeT> : &Writer::writeVectorListOp<T, SizeT>;
+          });
+        }));
+        ++first;
+      }
+      else
+      {
+        auto last = first + 1;
+        while (last != properties.end() && last - first < MaxFusedProperties && !last->isList() &&
+               last->type() == first->type())
+        {
+          ++last;
+        }
+
+        program.push_back(detail::visitType(first->type(), [n = last - first](auto type) -> WriteOp {
+          using T = typename decltype(type)::DestT;
+          switch (n)
+          {
+            case 1:
+              return &Writer::writeNumbersOp<T, 1>;
+            case 2:
+              return &Writer::writeNumbersOp<T, 2>;
+            case 3:
+              return &Writer::writeNumbersOp<T, 3>;
+          }
+          return &Writer::writeNumbersOp<T, 4>;
+        }));
+        first = last;
+      }
+    }
+
+    return program;
+  }
+
+  /// Write operation for `N` consecutive scalar properties of type `T`.
+  template<typename T, std::size_t N>
+  const std::uint8_t *writeNumbersOp(const std::uint8_t *src, const std::uint8_t *) const
+  {
+    if constexpr (N == 1) { return writeProperty<T>(src, reflect::Type<T>{}); }
+    else { return writeProperty<T>(src, reflect::Type<reflect::Pack<T, N>>{}); }
+  }
+
+  /// Write operation for a list property of type `T`, stored in a vector.
+  template<typename T, typename SizeT>
+  const std::uint8_t *writeVectorListOp(const std::uint8_t *src, const std::uint8_t *) const
+  {
+    return writeListProperty<T, SizeT>(src, reflect::Type<std::vector<T>>{});
+  }
+
+  /// Write operation for a list property of type `T`, stored in a list arena.
+  template<typename T, typename SizeT>
+  const std::uint8_t *writeArenaListOp(const std::uint8_t *src, const std::uint8_t *listArena) const
+  {
+    return writeListProperty<T, SizeT>(src, ArenaList<T, const std::uint8_t *>{listArena});
+  }
+
   template<typename PlyT, typename SrcT>
   const std::uint8_t *writeProperty(const std::uint8_t *src, reflect::Type<SrcT>) const
   {
@@ -194,6 +308,18 @@ private:
     return src + N * sizeof(SrcT);
   }
 
+  /// Specialization for a list stored in a list arena.
+  template<typename PlyT, typename PlySizeT, typename SrcT>
+  const std::uint8_t *writeListProperty(const std::uint8_t *src, ArenaList<SrcT, const std::uint8_t *> tag)
+      const
+  {
+    src = static_cast<const std::uint8_t *>(detail::align(src, alignof(PlyListRef)));
+    PlyListRef ref;
+    std::memcpy(&ref, src, sizeof(PlyListRef));
+    this->template writeList<PlySizeT, PlyT, SrcT>(reinterpret_cast<const SrcT *>(tag.arena + ref.offset), ref.size);
+    return src + sizeof(PlyListRef);
+  }
+
   /// Specialization for a vector of type `T`.
   template<typename PlyT, typename PlySizeT, typename SrcT>
   const std::uint8_t *writeListProperty(const std::uint8_t *src, reflect::Type<std::vector<SrcT>>) const
@@ -36,10 +36,15 @@ class WriterVariant
 public:
   WriterVariant(std::ostream &os, PlyFormat format) : variant_{makeVariant(os, format)} {}
 
-  void write(const PlyElement &element, const std::uint8_t *src, std::size_t alignment) const
+  void write(
+      const PlyElement &element,
+      const std::uint8_t *src,
+      std::size_t alignment,
+      const std::uint8_t *listArena = nullptr) const
   {
     std::visit(
-        [&element, src, alignment](auto &&writer) { writer.write(element, src, alignment); }, variant_);
+        [&element, src, alignment, listArena](auto &&writer) { writer.write(element, src, alignment, listArena); },
+        variant_);
   }
 
   template<typename... Ts>
@@ -48,6 +53,14 @@ public:
     std::visit([&element, layout](auto &&writer) { writer.write(element, layout); }, variant_);
   }
 
+  /// Writes all buffered data to the output stream. Errors that occur while
+  /// doing so are reported here; they are suppressed in case the buffered
+  /// data is written when the writer goes out of scope.
+  void flush() const
+  {
+    std::visit([](auto &&writer) { writer.flush(); }, variant_);
+  }
+
 private:
   using Variant = std::variant<
       detail::Writer<detail::AsciiWriterPolicy>,
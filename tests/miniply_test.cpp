@@ -7,7 +7,7 @@ triangular mesh and write that mesh back to hard drive.
 License: Public Domain
 
 Compilation:
-g++ -I<path_to_msh> -Iminiply/ -O2 -std=c++11 miniply/miniply.cpp miniply_test.cpp -o bin/miniply_test
+g++ -I<path_to_msh> -Iminiply/ -O2 -std=c++11 -pthread miniply/miniply.cpp miniply_test.cpp -o bin/miniply_test
 
 Notes:
 - miniply is super fast in general, but it especially excels in parsing ascii files.
@@ -33,7 +33,7 @@ read_ply( const char* filename, TriMesh* mesh, bool *is_binary )
 {
   int32_t verts_per_face = 3;
 
-  miniply::PLYReader reader(filename);
+  miniply::PLYReader reader(filename, miniply::PLYReadMode::MemoryMapped);
   if (!reader.valid()) {
     return false;
   }
@@ -52,20 +52,20 @@ read_ply( const char* filename, TriMesh* mesh, bool *is_binary )
   {
     if (!gotVerts && reader.element_is(miniply::kPLYVertexElement))
     {
-      if (!reader.load_element()) { break; }
       uint32_t propIdxs[3];
       if (!reader.find_pos(propIdxs)) { break; }
       mesh->n_verts = reader.num_rows();
       mesh->vertices = new Vec3f[mesh->n_verts];
-      reader.extract_properties(propIdxs, 3, miniply::PLYPropertyType::Float, mesh->vertices );
+      reader.set_destination(propIdxs, 3, miniply::PLYPropertyType::Float, mesh->vertices );
+      if (!reader.load_element()) { break; }
       gotVerts = true;
     }
     else if (!gotFaces && reader.element_is(miniply::kPLYFaceElement))
     {
-      if (!reader.load_element()) { break; }
       mesh->n_faces = reader.num_rows();
       mesh->faces = new Tri[mesh->n_faces];
-      reader.extract_properties(listIdxs.data(), verts_per_face, miniply::PLYPropertyType::Int, mesh->faces );
+      reader.set_destination(listIdxs.data(), verts_per_face, miniply::PLYPropertyType::Int, mesh->faces );
+      if (!reader.load_element()) { break; }
       gotFaces = true;
     }
     reader.next_element();
@@ -79,11 +79,29 @@ read_ply( const char* filename, TriMesh* mesh, bool *is_binary )
 void
 write_ply( const char* filename, TriMesh* mesh, bool is_binary )
 {
+  miniply::PLYWriter writer(filename, is_binary ? miniply::PLYFileType::Binary : miniply::PLYFileType::ASCII);
+  if (!writer.valid()) {
+    return;
+  }
+
+  uint32_t vertsIdx = writer.add_element(miniply::kPLYVertexElement, mesh->n_verts);
+  uint32_t posIdxs[3] = {
+    writer.add_property(vertsIdx, "x", miniply::PLYPropertyType::Float),
+    writer.add_property(vertsIdx, "y", miniply::PLYPropertyType::Float),
+    writer.add_property(vertsIdx, "z", miniply::PLYPropertyType::Float)
+  };
+  writer.set_source(vertsIdx, posIdxs, 3, miniply::PLYPropertyType::Float, mesh->vertices);
+
+  uint32_t facesIdx = writer.add_element(miniply::kPLYFaceElement, mesh->n_faces);
+  uint32_t indicesIdx = writer.add_list_property(facesIdx, "vertex_indices", miniply::PLYPropertyType::UChar, miniply::PLYPropertyType::Int);
+  writer.set_list_source(facesIdx, indicesIdx, 3, miniply::PLYPropertyType::Int, mesh->faces);
+
+  writer.write();
 }
 
 int
 main( int argc, char** argv )
 {
-  bool is_able_to_write_ply = false;
+  bool is_able_to_write_ply = true;
   return run_test("miniply_test", is_able_to_write_ply, argc, argv );
 }
\ No newline at end of file